@@ -0,0 +1,48 @@
+#ifndef ASSET_MANAGER_H_
+#define ASSET_MANAGER_H_
+
+#include <map>
+#include <string>
+#include <thread>
+
+#include <SFML/Graphics.hpp>
+#include "mapgen/IconAtlas.hpp"
+
+// Loads fonts, images and shader sources next to the executable.
+// Images are decoded on worker threads and cached in a binary pack
+// (decoded pixels + packed icon atlas) keyed by file mtime.
+class AssetManager {
+public:
+  AssetManager();
+  ~AssetManager();
+
+  std::string path(std::string name) const;
+  void preload();
+  void wait();
+  void reportFrame(std::string name);
+
+  sf::Font font;
+  std::map<std::string, sf::Image> images;
+  std::map<std::string, std::string> shaders;
+  IconAtlas atlas;
+  sf::Image atlasImage;
+
+  sf::Clock startup;
+  sf::Time loadTime;
+  std::map<std::string, sf::Time> frames;
+  int cached = 0;
+  int decoded = 0;
+
+private:
+  std::string root;
+  std::string packPath;
+  std::thread loader;
+  std::map<std::string, long long> mtimes;
+
+  void load();
+  bool readPack(std::map<std::string, long long> &packed, bool &atlasValid);
+  void writePack();
+  std::string readFile(std::string name) const;
+};
+
+#endif
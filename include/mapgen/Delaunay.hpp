@@ -0,0 +1,47 @@
+#ifndef DELAUNAY_H_
+#define DELAUNAY_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "mapgen/RegionStore.hpp"
+
+// Sweep-hull Delaunay triangulation over flat site coordinates. Triangles
+// and half-edges are index arrays (half-edge e belongs to triangle e / 3,
+// halfedges[e] is its twin or -1 on the hull), and the dual Voronoi cells
+// are written straight into a RegionStore, without a pointer graph.
+// Cells on the hull are left open: they hold only their circumcentres.
+// libmapgen builds the map from its own Fortune diagram and has no
+// backend hook, so this is only exercised by `--bench` for now.
+class Delaunay {
+public:
+  void build(const std::vector<double> &coords);
+  void fill(RegionStore &store) const;
+  std::size_t size() const;
+  std::size_t bytes() const;
+  static void benchmark();
+
+  std::vector<double> coords;
+  std::vector<std::uint32_t> triangles;
+  std::vector<std::int32_t> halfedges;
+  std::vector<std::uint32_t> hull;
+
+private:
+  std::uint32_t addTriangle(std::uint32_t i0, std::uint32_t i1,
+                            std::uint32_t i2, std::int32_t a, std::int32_t b,
+                            std::int32_t c);
+  std::uint32_t legalize(std::uint32_t a);
+  void link(std::int32_t a, std::int32_t b);
+  std::size_t hashKey(double x, double y) const;
+
+  std::vector<std::uint32_t> hullPrev;
+  std::vector<std::uint32_t> hullNext;
+  std::vector<std::uint32_t> hullTri;
+  std::vector<std::int32_t> hullHash;
+  std::vector<std::uint32_t> edgeStack;
+  std::uint32_t hullStart = 0;
+  double cx = 0;
+  double cy = 0;
+};
+
+#endif
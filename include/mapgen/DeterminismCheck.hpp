@@ -0,0 +1,35 @@
+#ifndef DETERMINISM_CHECK_H_
+#define DETERMINISM_CHECK_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapgen/MapGenerator.hpp"
+
+// Hashes of one stage from two runs that should agree: two generations
+// of the same seed for map stages, 1 and N threads for viewer stages.
+struct StageResult {
+  std::string name;
+  std::uint64_t reference;
+  std::uint64_t candidate;
+};
+
+// Generates the current seed twice and compares the map stage hashes,
+// then runs every threaded viewer stage with 1 and N threads and compares
+// their outputs.
+class DeterminismCheck {
+public:
+  DeterminismCheck(MapGenerator *m);
+  bool run(int threads = 0);
+  void setMapGenerator(MapGenerator *m);
+
+  std::vector<StageResult> results;
+  bool passed = false;
+  bool done = false;
+
+private:
+  MapGenerator *mapgen;
+};
+
+#endif
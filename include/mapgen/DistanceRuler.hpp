@@ -0,0 +1,57 @@
+#ifndef DISTANCE_RULER_H_
+#define DISTANCE_RULER_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include "mapgen/HeightCache.hpp"
+#include "mapgen/Map.hpp"
+#include "mapgen/Region.hpp"
+
+// Distance ruler from a fixed origin. Two shortest-path trees are built
+// once per origin: along roads and sea paths, and over terrain (land
+// cost model). Hovering a region only walks its parent chains.
+class DistanceRuler : public sf::Drawable {
+public:
+  void setOrigin(Region *origin, Map *map, sf::Font &font);
+  void hover(Region *target);
+  void clear();
+
+  Region *origin = nullptr;
+  Region *target = nullptr;
+  float straight = 0.f;
+  float network = -1.f;
+  float terrain = -1.f;
+  sf::Time buildTime;
+  const HeightCache *heights = nullptr;
+
+private:
+  struct Tree {
+    std::vector<float> cost;
+    std::vector<float> length;
+    std::vector<int> parent;
+  };
+
+  std::vector<Region *> regions;
+  std::unordered_map<Region *, int> index;
+  Tree roads;
+  Tree land;
+
+  sf::ConvexShape originShape;
+  sf::CircleShape originSite;
+  sf::VertexArray straightLine;
+  sf::VertexArray roadRoute;
+  sf::VertexArray landRoute;
+  sf::RectangleShape labelBg;
+  sf::Text label;
+
+  void dijkstra(Tree &tree, int source,
+                const std::vector<std::vector<std::pair<int, float>>> &edges);
+  float walk(const Tree &tree, int to, sf::VertexArray &route,
+             sf::Color color) const;
+  virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+};
+
+#endif
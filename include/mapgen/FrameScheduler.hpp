@@ -0,0 +1,54 @@
+#ifndef FRAME_SCHEDULER_H_
+#define FRAME_SCHEDULER_H_
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+
+// Measures frame times and spreads expensive work across frames.
+// "present" is the time spent in display(), i.e. waiting for the GPU/vsync.
+class FrameScheduler {
+public:
+  FrameScheduler(int history = 240);
+
+  void beginFrame();
+  void endCpu();
+  void endFrame();
+
+  void defer(std::string name, std::function<void()> task);
+  void runDeferred();
+  void clear();
+  bool pending() const;
+  int deferred() const;
+
+  float percentile(float p) const;
+  float cpuPercentile(float p) const;
+  float presentPercentile(float p) const;
+
+  float budget = 12.f;
+
+private:
+  struct Task {
+    std::string name;
+    std::function<void()> run;
+  };
+  std::deque<Task> tasks;
+
+  int history;
+  int cursor = 0;
+  int samples = 0;
+  std::vector<float> frameTimes;
+  std::vector<float> cpuTimes;
+  std::vector<float> presentTimes;
+
+  sf::Clock frameClock;
+  sf::Clock presentClock;
+  float cpuTime = 0.f;
+
+  float pick(const std::vector<float> &times, float p) const;
+};
+
+#endif
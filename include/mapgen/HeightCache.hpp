@@ -0,0 +1,41 @@
+#ifndef HEIGHT_CACHE_H_
+#define HEIGHT_CACHE_H_
+
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/Region.hpp"
+
+// Heights of every region site and polygon vertex, sampled once per map
+// in parallel batches and stored as flat arrays in map order. Lookups are
+// always the exact noise heights; the height raster is only used for
+// relief shading and export, so nothing changes when it is baked.
+class HeightCache {
+public:
+  void build(std::vector<Region *> &regions, int threads = 0);
+  void clear();
+  bool ready() const;
+  std::size_t bytes() const;
+  void write(std::ostream &out) const;
+  bool read(std::istream &in, std::vector<Region *> &regions);
+
+  float site(Region *region) const;
+  float vertex(Region *region, int i) const;
+
+  static void sample(const std::vector<Region *> &owners,
+                     const std::vector<Point> &points, std::vector<float> &out,
+                     int threads = 0);
+
+  std::vector<float> siteHeight;
+  std::vector<int> vertexStart;
+  std::vector<float> vertexHeight;
+  sf::Time buildTime;
+
+private:
+  std::unordered_map<Region *, int> index;
+  int indexOf(Region *region) const;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef HEIGHT_RASTER_H_
+#define HEIGHT_RASTER_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include "mapgen/Region.hpp"
+
+// Heightmap baked once per map in parallel tiles, read back with bilinear
+// interpolation. Also the source for relief shading and height export.
+class HeightRaster {
+public:
+  void bake(Region *sampler, float mapWidth, float mapHeight, int resolution,
+            int threads = 0);
+  void clear();
+  bool ready() const;
+  std::size_t bytes() const;
+  float at(float x, float y) const;
+
+  void shade(sf::Image &image) const;
+  bool save(std::string path) const;
+  void write(std::ostream &out) const;
+  bool read(std::istream &in);
+  void benchmark(Region *sampler, int samples = 200000);
+
+  int width = 0;
+  int height = 0;
+  float mapWidth = 0.f;
+  float mapHeight = 0.f;
+  std::vector<float> data;
+  sf::Time bakeTime;
+
+  // Largest side bake accepts through the UI; bounds cached rasters too.
+  static const int maxSide = 8192;
+
+  float meanError = 0.f;
+  float maxError = 0.f;
+  float rasterNs = 0.f;
+  float noiseNs = 0.f;
+
+private:
+  float minHeight = 0.f;
+  float maxHeight = 0.f;
+  static const int tile = 64;
+};
+
+#endif
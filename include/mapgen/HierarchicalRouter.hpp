@@ -0,0 +1,69 @@
+#ifndef HIERARCHICAL_ROUTER_H_
+#define HIERARCHICAL_ROUTER_H_
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/Cluster.hpp"
+#include "mapgen/Region.hpp"
+#include "mapgen/RegionGraph.hpp"
+
+// Two-level router: clusters form an abstract graph connected through
+// portal regions on their shared borders. A route is planned over
+// clusters first, then refined with region-level A* between consecutive
+// portals, each leg restricted to the clusters around it.
+class HierarchicalRouter {
+public:
+  // Per-thread search state; stamps avoid clearing O(regions) per query.
+  struct Search {
+    std::vector<float> cost;
+    std::vector<int> parent;
+    std::vector<unsigned int> stamp;
+    std::vector<unsigned int> closed;
+    std::vector<unsigned int> allowed;
+    unsigned int generation = 0;
+  };
+
+  void build(std::vector<Region *> &regions, std::vector<Cluster *> &clusters);
+  void clear();
+  bool ready() const;
+  std::size_t bytes() const;
+  std::vector<Region *> route(Region *from, Region *to, CostModel model,
+                              Search &search) const;
+
+  int portals = 0;
+  const HeightCache *heights = nullptr;
+  sf::Time buildTime;
+
+  // Routes planned over clusters, and how many of them had to fall back
+  // to a wider search because a portal-to-portal leg failed.
+  mutable std::atomic<int> routes{0};
+  mutable std::atomic<int> fallbacks{0};
+
+private:
+  std::vector<Region *> regions;
+  std::unordered_map<Region *, int> regionIndex;
+  std::vector<int> regionCluster;
+  std::vector<int> neighborStart;
+  std::vector<int> neighbors;
+
+  std::vector<Cluster *> clusters;
+  std::vector<sf::Vector2f> clusterCenter;
+  // Cluster adjacency (CSR): neighbour cluster and the portal region on
+  // this side of the shared border.
+  std::vector<int> edgeStart;
+  std::vector<int> edgeCluster;
+  std::vector<int> edgePortal;
+
+  bool clusterPassable(int cluster, CostModel model, int from, int to) const;
+  int shore(int port, int toward) const;
+  bool corridor(int from, int to, CostModel model, std::vector<int> &path,
+                std::vector<int> &exits) const;
+  std::vector<Region *> refine(int from, int to, CostModel model,
+                               const std::vector<int> &allowed,
+                               Search &search) const;
+};
+
+#endif
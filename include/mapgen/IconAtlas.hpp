@@ -0,0 +1,43 @@
+#ifndef ICON_ATLAS_H_
+#define ICON_ATLAS_H_
+
+#include <map>
+#include <string>
+
+#include <SFML/Graphics.hpp>
+
+// Packs small images into one texture, so icons can share a single bind.
+class IconAtlas {
+public:
+  IconAtlas(unsigned int padding = 2);
+  void add(std::string name, const sf::Image &image);
+  bool pack(sf::Image &atlas);
+  bool load(const sf::Image &atlas, bool mipmap = false);
+  bool build(bool mipmap = false);
+  bool has(std::string name) const;
+  sf::IntRect getRect(std::string name) const;
+
+  sf::Texture texture;
+  std::map<std::string, sf::IntRect> rects;
+
+private:
+  unsigned int padding;
+  std::map<std::string, sf::Image> pending;
+};
+
+// Quads with per-icon texture rects from an atlas, drawn with one call.
+class IconBatch : public sf::Drawable {
+public:
+  IconBatch(IconAtlas *atlas);
+  void add(std::string name, sf::Vector2f position,
+           sf::Color color = sf::Color::White);
+  void clear();
+  std::size_t size() const;
+
+private:
+  IconAtlas *atlas;
+  sf::VertexArray vertices;
+  virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include <SFML/Graphics/RenderWindow.hpp>
+#include "mapgen/HeightCache.hpp"
 #include "mapgen/Region.hpp"
 
 class InfoWindow {
@@ -6,4 +7,5 @@ public:
   InfoWindow(sf::RenderWindow *w);
   void draw(Region* currentRegion);
   sf::RenderWindow *window;
+  HeightCache *heights = nullptr;
 };
@@ -14,7 +14,7 @@ public:
   sf::Shader* shader = nullptr;
   void clear();
   void add(sf::Drawable* shape);
-  void update(sf::RenderWindow* w);
+  void update(sf::RenderWindow* w, const sf::View& view);
   Layer* mask = nullptr;
   sf::Shader* shader_mask;
   sf::RenderTexture* cache = nullptr;
@@ -34,6 +34,9 @@ private:
 public:
   LayersManager(sf::RenderWindow* w, sf::Shader* shader_mask);
   std::vector<Layer*> layers;
+  // Shapes are rasterized through this view; the caches themselves are
+  // always window-sized.
+  sf::View view;
 
   Layer* getLayer(std::string name);
   void setLayerEnabled(std::string name, bool enabled);
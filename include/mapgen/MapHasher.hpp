@@ -0,0 +1,75 @@
+#ifndef MAP_HASHER_H_
+#define MAP_HASHER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/HeightCache.hpp"
+#include "mapgen/MapGenerator.hpp"
+
+// Streaming FNV-1a: values are folded in as they are visited, nothing is
+// buffered. Floats are hashed by their bits.
+class ContentHash {
+public:
+  template <typename T> void add(const T &value) {
+    bytes(reinterpret_cast<const unsigned char *>(&value), sizeof(T));
+  }
+  template <typename T> void add(const std::vector<T> &values) {
+    add(values.size());
+    bytes(reinterpret_cast<const unsigned char *>(values.data()),
+          values.size() * sizeof(T));
+  }
+  void add(const std::string &value) {
+    add(value.size());
+    bytes(reinterpret_cast<const unsigned char *>(value.data()), value.size());
+  }
+  void add(Point point) {
+    add(point->x);
+    add(point->y);
+  }
+  std::uint64_t value = 0xcbf29ce484222325ull;
+
+private:
+  void bytes(const unsigned char *data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+      value = (value ^ data[i]) * 0x100000001b3ull;
+    }
+  }
+};
+
+// Content hashes of a generated map, one per stage. Stages refer to
+// regions by their site, so each one can be hashed on its own.
+class MapHasher {
+public:
+  enum Stage {
+    GEOMETRY,
+    HEIGHTS,
+    BIOMES,
+    CLUSTERS,
+    RIVERS,
+    ROADS,
+    CITIES,
+    WEATHER,
+    STAGES
+  };
+  static const char *names[STAGES];
+
+  MapHasher(MapGenerator *m);
+  void hash(const HeightCache *heights = nullptr, int threads = 0);
+  std::uint64_t stage(Stage s, const HeightCache *heights = nullptr) const;
+  std::uint64_t combined() const;
+  void clear();
+  void setMapGenerator(MapGenerator *m);
+  bool ready() const;
+  void benchmark(const HeightCache *heights = nullptr, int runs = 20) const;
+
+  std::vector<std::uint64_t> stages;
+  sf::Time hashTime;
+
+private:
+  MapGenerator *mapgen;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "mapgen/MapGenerator.hpp"
+#include "mapgen/FrameScheduler.hpp"
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/ConvexShape.hpp>
 #include <functional>
@@ -21,15 +22,22 @@ private:
 
   void higlightLocation(Location *location);
 
+  void higlightRegions(void *key, std::vector<Region *> regions, sf::Color col);
+
+  std::map<void *, std::vector<sf::ConvexShape>> highlights;
+
 public:
   ObjectsWindow(sf::RenderWindow *w, MapGenerator *m);
 
-  std::vector<sf::ConvexShape> objectPolygons;
+  FrameScheduler *scheduler = nullptr;
+  std::vector<sf::ConvexShape *> objectPolygons;
   std::vector<bool> selection_mask;
   std::vector<bool> mega_selection_mask;
   std::vector<bool> rivers_selection_mask;
   std::vector<bool> cities_selection_mask;
   std::vector<bool> location_selection_mask;
 
+  void invalidate();
+  void setMapGenerator(MapGenerator *m);
   void draw();
 };
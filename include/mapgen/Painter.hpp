@@ -1,11 +1,21 @@
 #pragma once
+#include <memory>
 #include <thread>
 
 #include <SFML/Graphics.hpp>
 
 #include "mapgen/Region.hpp"
-#include "mapgen/Walker.hpp"
+#include "mapgen/WalkerSystem.hpp"
 #include "mapgen/Layers.hpp"
+#include "mapgen/IconAtlas.hpp"
+#include "mapgen/AssetManager.hpp"
+#include "mapgen/FrameScheduler.hpp"
+#include "mapgen/HeightCache.hpp"
+#include "mapgen/HeightRaster.hpp"
+#include "mapgen/RegionStore.hpp"
+#include "mapgen/TileMesh.hpp"
+#include "mapgen/WindField.hpp"
+#include "mapgen/WindParticles.hpp"
 #include "mapgen/utils.hpp"
 
 #include "SelbaWard/SelbaWard.hpp"
@@ -20,7 +30,7 @@ public:
 class Painter {
 
 public:
-  Painter(sf::RenderWindow *w, MapGenerator *m, std::string v);
+  Painter(sf::RenderWindow *w, MapGenerator *m, AssetManager *a, std::string v);
   sf::Font sffont;
 
   std::vector<DrawableRegion> polygons;
@@ -29,12 +39,23 @@ public:
   std::vector<sf::ConvexShape> infoPolygons;
   std::vector<sf::CircleShape> poi;
   std::vector<sf::Sprite> sprites;
+  HeightCache heightCache;
+  HeightRaster heightRaster;
+  RegionStore store;
+  TileMesh landMesh;
+  TileMesh landBorderMesh;
+  TileMesh waterMesh;
+  // World view of the map; only large map mode zooms and pans it.
+  sf::View camera;
+  int rasterResolution = 1024;
 
   bool borders = false;
   bool edges = false;
   bool info = false;
   bool verbose = true;
   bool heights = false;
+  bool relief = false;
+  bool largeMap = false;
   bool hum = false;
   bool temp = false;
   bool minerals = false;
@@ -44,20 +65,30 @@ public:
   bool states = true;
   bool areas = false;
   bool showWalkers = true;
+  int walkersCount = 0;
   bool labels = true;
   bool blur = false;
   bool showSeaPathes = false;
   bool wind = false;
+  bool windArrows = true;
+  bool windParticles = false;
+  int windParticlesCount = 2000;
 
 
+  // Set while a sweep changes the simulation state: layers are not rebuilt
+  // and the cached map stays on screen until it is cleared.
+  bool frozen = false;
+
   bool useTextures = false;
   bool useCacheMap = true;
+  bool mipmapIcons = false;
   int hueDelta = 7;
   float lumDelta = 18.f;
   int landBorderHeight = 4;
   int forrestBorderHeight = 5;
 
   LayersManager *layers;
+  FrameScheduler *scheduler = nullptr;
   sf::Shader shader_lesser_blur;
   sf::Shader shader_mask;
 
@@ -66,25 +97,46 @@ public:
   void initProgressBar();
   void loadImages();
   void invalidate(bool force = false);
+  void invalidateWeather();
+  bool isDirty();
+  bool isAnimating();
   void fade();
   void drawLoading();
   void drawInfo(Region *currentRegion);
+  void updateHighlight(Region *currentRegion);
   void drawRivers();
   sw::Spline* drawRoad(Road *r);
   void drawRoads();
   void drawLabels();
   void drawMap();
+  void composeMap();
   void drawBorders();
   void nextBorder(Region *r, std::vector<Region *> *used, sw::Spline *line,
   std::vector<Region *> *ends, std::vector<Region *> *exclude);
   void drawMark();
-  void drawObjects(std::vector<sf::ConvexShape> op);
+  void drawObjects(std::vector<sf::ConvexShape *> &op);
   void update();
   sf::Texture getScreenshot();
   void draw();
   void drawWalkers();
+  void resetWalkers();
   void drawPolygons();
   void drawWind();
+  void drawWindParticles();
+  void drawRelief();
+  void drawPolygonTiles();
+  void streamTiles();
+  void setCamera(const sf::View &view);
+  void resetCamera();
+  void setMeshBudget(std::size_t bytes);
+  std::size_t meshBytes() const;
+  sf::Color getColor(Region *region);
+  std::vector<std::pair<std::string, std::size_t>> memoryReport();
+  std::shared_ptr<WindField> getWindField();
+  void setWindField(std::shared_ptr<WindField> field);
+  void dropWindField();
+  void setMapGenerator(MapGenerator *m);
+  void reloadIcons();
   void drawLakes();
   void drawLocations();
   void drawHeights();
@@ -94,21 +146,35 @@ public:
   sf::ConvexShape *getPolygon(Region *region);
 
 private:
-  std::map<LocationType, sf::Texture *> locationIcons;
+  std::map<LocationType, std::string> locationIcons;
   std::map<std::string, sf::Texture *> images;
+  IconAtlas *iconAtlas = nullptr;
+  IconBatch *locationBatch = nullptr;
   sf::RenderWindow *window;
   sw::ProgressBar progressBar;
   sf::RenderTexture cachedMap;
+  sf::Sprite cachedSprite;
   sf::Color bgColor;
   float color[3] = {0.12f, 0.12f, 0.12f};
   Map *map;
   MapGenerator *mapgen;
+  AssetManager *assets;
   std::string VERSION;
   bool needUpdate = true;
+  bool cameraOnly = false;
   sf::Clock clock;
-  std::vector<Walker *> walkers;
+  WalkerSystem walkers;
+  sf::Clock walkersClock;
+  std::shared_ptr<WindField> windField;
+  sf::VertexArray windLines;
+  sf::Texture reliefTexture;
+  sf::Sprite reliefSprite;
+  WindParticles particles;
+  sf::Clock particlesClock;
   sf::Shader shader_blur;
   float iconSize = 24.f;
 
   Region *currentRegionCache = nullptr;
+
+  void defer(std::string name, std::function<void()> task);
 };
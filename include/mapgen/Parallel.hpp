@@ -0,0 +1,36 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Splits [0, n) into contiguous chunks and runs fn(begin, end) on each
+// chunk in its own thread. Small ranges run inline.
+inline void parallelFor(int n, std::function<void(int, int)> fn,
+                        int threads = 0, int grain = 1024) {
+  if (threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, std::max(1, n / grain));
+  if (threads <= 1) {
+    fn(0, n);
+    return;
+  }
+  std::vector<std::thread> workers;
+  int chunk = (n + threads - 1) / threads;
+  for (int t = 0; t < threads; t++) {
+    int begin = t * chunk;
+    int end = std::min(n, begin + chunk);
+    if (begin >= end) {
+      break;
+    }
+    workers.push_back(std::thread(fn, begin, end));
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+#endif
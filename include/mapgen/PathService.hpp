@@ -0,0 +1,77 @@
+#ifndef PATH_SERVICE_H_
+#define PATH_SERVICE_H_
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/City.hpp"
+#include "mapgen/HierarchicalRouter.hpp"
+#include "mapgen/Region.hpp"
+#include "mapgen/RegionGraph.hpp"
+#include "micropather.h"
+
+struct PathQuery {
+  Region *from;
+  Region *to;
+  CostModel model;
+};
+
+// Routes region to region through micropather, or through the cluster
+// hierarchy when the endpoints lie in different clusters. Results are
+// memoised per (from, to, cost model); batches run on worker threads,
+// each with its own pather per cost model, so the pathers' node caches
+// are reused across the queries of a thread. A query that is already
+// being solved on another thread waits for that result instead of
+// solving it again. The counters cover one map: a fresh service is
+// built for every generation.
+class PathService {
+public:
+  PathService();
+  ~PathService();
+
+  std::vector<Region *> route(Region *from, Region *to, CostModel model);
+  std::vector<std::vector<Region *>> routeAll(std::vector<PathQuery> &queries,
+                                              int threads = 0);
+  std::vector<PathQuery> cityPairs(std::vector<City *> &cities,
+                                   CostModel model);
+  void build(std::vector<Region *> &regions, std::vector<Cluster *> &clusters,
+             const HeightCache *heights = nullptr);
+  void clear();
+  void clearMemo();
+  float hitRate() const;
+  std::size_t bytes() const;
+
+  HierarchicalRouter hierarchy;
+  bool hierarchical = true;
+
+  int queries = 0;
+  int hits = 0;
+  int unreachable = 0;
+  sf::Time routingTime;
+
+private:
+  struct Worker {
+    RegionGraph graph;
+    micropather::MicroPather pather;
+    HierarchicalRouter::Search search;
+    Worker(CostModel model, const HeightCache *heights);
+  };
+  std::vector<std::vector<std::unique_ptr<Worker>>> workers;
+  typedef std::tuple<Region *, Region *, int> Key;
+  std::map<Key, std::vector<Region *>> memo;
+  std::set<Key> solving;
+  mutable std::mutex mutex;
+  std::condition_variable solved;
+
+  Worker *worker(int thread, CostModel model);
+  bool cached(PathQuery &query, std::vector<Region *> &path);
+  std::vector<Region *> solve(Worker *w, PathQuery &query);
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <cstdint>
+
+// Counter-based random numbers: every value is a hash of (seed, stream,
+// index, draw), so an element of a stage gets the same numbers no matter
+// which thread handles it or in which order. Streams are named per stage.
+class RandomStream {
+public:
+  RandomStream(std::uint64_t seed = 0, const char *name = "")
+      : key(mix(seed ^ mix(hash(name)))) {}
+
+  std::uint64_t bits(std::uint64_t index, std::uint64_t draw = 0) const {
+    return mix(mix(key + index * 0x9e3779b97f4a7c15ull) ^
+               (draw + 1) * 0xd1b54a32d192ed03ull);
+  }
+
+  // [0, 1)
+  float uniform(std::uint64_t index, std::uint64_t draw = 0) const {
+    return float(bits(index, draw) >> 40) / float(1ull << 24);
+  }
+
+  float range(std::uint64_t index, std::uint64_t draw, float lo,
+              float hi) const {
+    return lo + (hi - lo) * uniform(index, draw);
+  }
+
+  // [0, n)
+  int below(std::uint64_t index, std::uint64_t draw, int n) const {
+    return n <= 0 ? 0 : int(bits(index, draw) % std::uint64_t(n));
+  }
+
+  static std::uint64_t hash(const char *name) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (; *name; name++) {
+      h = (h ^ std::uint64_t(static_cast<unsigned char>(*name))) *
+          0x100000001b3ull;
+    }
+    return h;
+  }
+
+private:
+  std::uint64_t key;
+
+  // splitmix64 finaliser
+  static std::uint64_t mix(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+  }
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef REGION_GRAPH_H_
+#define REGION_GRAPH_H_
+
+#include "mapgen/HeightCache.hpp"
+#include "mapgen/Region.hpp"
+#include "micropather.h"
+
+enum CostModel { LAND_ROUTE, SEA_ROUTE };
+
+// micropather adapter over the region adjacency graph.
+class RegionGraph : public micropather::Graph {
+public:
+  RegionGraph(CostModel m);
+  float cost(Region *from, Region *to) const;
+  bool passable(Region *region) const;
+
+  virtual float LeastCostEstimate(void *start, void *end);
+  virtual void AdjacentCost(void *state,
+                            MP_VECTOR<micropather::StateCost> *adjacent);
+  virtual void PrintStateInfo(void *state);
+
+  CostModel model;
+  const HeightCache *heights = nullptr;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef REGION_STORE_H_
+#define REGION_STORE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "mapgen/Cluster.hpp"
+#include "mapgen/Region.hpp"
+
+// Compact copy of the region geometry: float coordinates and 32-bit
+// indices in flat arrays (polygons and neighbours in CSR layout), so
+// viewer stages can walk large maps without chasing region pointers.
+class RegionStore {
+public:
+  void build(std::vector<Region *> &regions, std::vector<Cluster *> &clusters);
+  void clear();
+  std::size_t size() const;
+  std::size_t bytes() const;
+  int indexOf(Region *region) const;
+
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<std::uint32_t> vertexStart;
+  std::vector<float> vx;
+  std::vector<float> vy;
+  std::vector<std::uint32_t> neighborStart;
+  std::vector<std::uint32_t> neighbors;
+  std::vector<std::uint32_t> cluster;
+  std::vector<std::uint8_t> land;
+
+private:
+  std::unordered_map<Region *, std::uint32_t> index;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SERIES_LOD_H_
+#define SERIES_LOD_H_
+
+#include <vector>
+
+// Append-only float series stored in fixed-size chunks, with a min/max
+// pyramid so a plot of any length can be drawn from a bounded number of
+// points without losing peaks.
+class SeriesLOD {
+public:
+  SeriesLOD(int chunkBits = 12);
+
+  bool sync(const std::vector<float> &source);
+  void push(float value);
+  void clear();
+
+  std::size_t size() const;
+  float at(std::size_t i) const;
+  float front() const;
+  float back() const;
+  float min() const;
+  float max() const;
+
+  const std::vector<float> &downsample(int points);
+
+  float scale = 1.f;
+
+private:
+  int chunkBits;
+  std::size_t chunkSize;
+  std::size_t count = 0;
+  // Running extremes, kept by push() so min()/max() are O(1).
+  float low = 0.f;
+  float high = 0.f;
+  std::vector<std::vector<float>> chunks;
+
+  // Level k, element j: min/max of samples [j * 2^(k+1), (j+1) * 2^(k+1)).
+  std::vector<std::vector<float>> mins;
+  std::vector<std::vector<float>> maxs;
+
+  std::vector<float> plot;
+  int plotPoints = 0;
+  bool dirty = true;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SIMULATION_SNAPSHOT_H_
+#define SIMULATION_SNAPSHOT_H_
+
+#include <vector>
+
+#include "mapgen/MapGenerator.hpp"
+
+// Everything a simulation run changes, stored as flat arrays in map order:
+// city population and wealth, region traffic (road usage is counted on the
+// regions a road runs through) and the simulator's report. Restoring it is
+// a full reset, so Simulator::resetAll is not needed. Geography is not
+// copied, so any number of snapshots (pristine state, saved variants) share
+// the same generated map.
+class SimulationSnapshot {
+public:
+  void capture(MapGenerator *gen);
+  bool restore(MapGenerator *gen) const;
+  bool matches(MapGenerator *gen) const;
+  void clear();
+  bool empty() const;
+  std::size_t bytes() const;
+
+  std::vector<decltype(City::population)> population;
+  std::vector<decltype(City::wealth)> wealth;
+  std::vector<decltype(Region::traffic)> traffic;
+  // Report at capture time; a map without a report restores to an empty one.
+  bool reported = false;
+  Report report;
+
+private:
+  std::vector<City *> cityKeys;
+  std::vector<Region *> regionKeys;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SIMULATION_SWEEP_H_
+#define SIMULATION_SWEEP_H_
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "mapgen/MapGenerator.hpp"
+#include "mapgen/SimulationSnapshot.hpp"
+
+struct SweepParam {
+  std::string name;
+  bool enabled = false;
+  float from = 0.f;
+  float to = 0.f;
+  int steps = 3;
+};
+
+// Runs the simulation for a grid or a random sample of economy variables
+// and writes one CSV row per run, plus the report series of every run.
+// Runs go one after another on the shown map: each one starts from the
+// pristine snapshot with rand() seeded from the map seed and the run index,
+// so a row can be reproduced on its own. The map's simulation state and
+// variables are put back afterwards.
+class SimulationSweep {
+public:
+  SimulationSweep(MapGenerator *m);
+  void run();
+  void cancel();
+  void setMapGenerator(MapGenerator *m);
+  float *var(std::string name);
+
+  std::vector<SweepParam> params;
+  bool random = false;
+  int samples = 16;
+  int seed = 0;
+  std::string path = "sweep.csv";
+  std::string seriesPath = "sweep-series.csv";
+  SimulationSnapshot *pristine = nullptr;
+
+  std::atomic<int> done{0};
+  std::atomic<int> total{0};
+  float msPerRun = 0.f;
+  float runsPerSecond = 0.f;
+
+private:
+  MapGenerator *mapgen;
+  std::atomic<bool> cancelled{false};
+  std::vector<std::vector<float>> combinations();
+};
+
+#endif
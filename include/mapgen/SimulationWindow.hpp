@@ -1,11 +1,35 @@
 #include "mapgen/MapGenerator.hpp"
+#include "mapgen/SeriesLOD.hpp"
+#include "mapgen/SimulationSnapshot.hpp"
+#include "mapgen/SimulationSweep.hpp"
+#include <map>
 #include <SFML/Graphics/RenderWindow.hpp>
 
 class SimulationWindow {
 private:
   sf::RenderWindow *window;
   MapGenerator *mapgen;
+
+  SeriesLOD population;
+  SeriesLOD wealth;
+  std::string populationLabel;
+  std::string wealthLabel;
+  int plotPoints = 256;
+
+  void exportReport(std::string path);
 public:
   SimulationWindow(sf::RenderWindow *w, MapGenerator *m);
   void draw();
+  void drawSweep();
+  void drawVariants();
+  void setMapGenerator(MapGenerator *m);
+
+  SimulationSweep *sweep;
+  bool sweepRequested = false;
+  // Set when a variant was loaded, so the application redraws the map.
+  bool variantLoaded = false;
+  std::atomic<bool> sweepRunning{false};
+
+  std::map<std::string, SimulationSnapshot> variants;
+  char variantName[64] = "variant";
 };
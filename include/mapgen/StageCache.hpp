@@ -0,0 +1,76 @@
+#ifndef STAGE_CACHE_H_
+#define STAGE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+
+// Viewer stages derived from a generated map (heights, raster) on disk,
+// one binary file per (stage, key). The key hashes everything a stage
+// depends on (parameters and upstream stage hashes), so a hit can be used
+// as is. Only the newest entries of every stage are kept. Generation
+// itself runs inside libmapgen and is not cached. Safe to use from the
+// generator and preview threads at once.
+class StageCache {
+public:
+  StageCache(std::string dir, int keep = 8);
+
+  bool read(const std::string &stage, std::uint64_t key,
+            std::function<bool(std::istream &)> fn);
+  void write(const std::string &stage, std::uint64_t key,
+             std::function<void(std::ostream &)> fn);
+  void purge();
+  std::size_t diskBytes() const;
+
+  template <typename T> static void put(std::ostream &out, T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  template <typename T> static T get(std::istream &in) {
+    T value{};
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return value;
+  }
+  template <typename T>
+  static void putVector(std::ostream &out, const std::vector<T> &values) {
+    put<std::uint64_t>(out, values.size());
+    out.write(reinterpret_cast<const char *>(values.data()),
+              values.size() * sizeof(T));
+  }
+  // The stored size must not exceed the count the caller expects, so a
+  // corrupt entry cannot make it allocate more than the stage needs.
+  template <typename T>
+  static bool getVector(std::istream &in, std::vector<T> &values,
+                        std::size_t max) {
+    auto size = get<std::uint64_t>(in);
+    if (!in || size > max) {
+      return false;
+    }
+    values.resize(size);
+    in.read(reinterpret_cast<char *>(values.data()), size * sizeof(T));
+    return bool(in);
+  }
+
+  std::atomic<bool> enabled{true};
+  std::atomic<int> hits{0};
+  std::atomic<int> misses{0};
+
+private:
+  std::string dir;
+  int keep;
+  // Kept up to date on write, prune and purge instead of scanning the
+  // directory for every query.
+  std::atomic<std::size_t> usage{0};
+  // Serialises directory changes (rename, prune, purge) and rescans.
+  std::mutex lock;
+  std::size_t scan() const;
+  std::string file(const std::string &stage, std::uint64_t key) const;
+  void prune(const std::string &stage);
+};
+
+#endif
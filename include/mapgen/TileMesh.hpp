@@ -0,0 +1,48 @@
+#ifndef TILE_MESH_H_
+#define TILE_MESH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include "mapgen/RegionStore.hpp"
+
+// Region polygons batched into one triangle array per square tile. build
+// only buckets regions by tile; the triangles of a tile are streamed in
+// when it first becomes visible, and tiles outside the view are evicted
+// least recently seen first once the resident vertices exceed the budget.
+// Tiles outside the view are skipped when drawing.
+class TileMesh : public sf::Drawable {
+public:
+  TileMesh(float tileSize = 512.f);
+  void build(const RegionStore &store, const std::vector<sf::Color> &colors,
+             const std::vector<char> &include, sf::Vector2f offset,
+             float width, float height);
+  void stream(const sf::FloatRect &visible);
+  void clear();
+  std::size_t bytes() const;
+  int tileCount() const;
+  int residentCount() const;
+
+  std::size_t budget = SIZE_MAX;
+
+private:
+  float tileSize;
+  int columns = 0;
+  int rows = 0;
+  const RegionStore *store = nullptr;
+  std::vector<sf::Color> colors;
+  sf::Vector2f offset;
+  std::vector<std::uint32_t> tileStart;
+  std::vector<std::uint32_t> tileRegions;
+  std::vector<sf::VertexArray> tiles;
+  std::vector<char> resident;
+  std::vector<std::uint32_t> lastSeen;
+  std::uint32_t frame = 0;
+
+  sf::FloatRect bounds(int tile) const;
+  void fill(int tile);
+  virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+};
+
+#endif
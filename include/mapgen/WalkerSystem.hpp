@@ -0,0 +1,55 @@
+#pragma once
+#include "mapgen/City.hpp"
+#include "mapgen/Road.hpp"
+#include "mapgen/MapGenerator.hpp"
+#include "mapgen/Random.hpp"
+#include "SelbaWard/SelbaWard.hpp"
+#include <SFML/Graphics.hpp>
+#include <map>
+
+// Walkers travelling between cities along roads.
+// Agents are stored as flat arrays and drawn as one quad batch; road
+// geometry is flattened once into polylines with arc-length tables.
+class WalkerSystem : public sf::Drawable {
+public:
+  WalkerSystem(MapGenerator *m);
+  void init(unsigned int seed, int count, std::map<Road *, sw::Spline *> &splines);
+  void tick(float dt);
+  void clear();
+  void setMapGenerator(MapGenerator *m);
+  std::size_t size() const;
+  bool initialized = false;
+
+  float speed = 40.f;
+  float radius = 2.f;
+
+private:
+  MapGenerator *mapgen;
+  RandomStream random;
+
+  // Roads: polyline points and cumulative lengths, indexed by roadStart.
+  std::vector<int> roadStart;
+  std::vector<int> roadPoints;
+  std::vector<int> roadFrom;
+  std::vector<int> roadTo;
+  std::vector<sf::Vector2f> points;
+  std::vector<float> arc;
+
+  // Cities: outgoing road indices, indexed by cityStart.
+  std::vector<int> cityStart;
+  std::vector<int> cityRoads;
+
+  // Agents.
+  std::vector<int> agentRoad;
+  std::vector<int> agentSegment;
+  std::vector<float> agentDistance;
+  std::vector<float> agentSpeed;
+  std::vector<char> agentReverse;
+  std::vector<unsigned int> agentDraws;
+
+  sf::VertexArray vertices;
+
+  void pickRoad(int agent, int city);
+  void place(int agent);
+  virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+};
@@ -0,0 +1,44 @@
+#ifndef WEATHER_JOB_H_
+#define WEATHER_JOB_H_
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/MapGenerator.hpp"
+#include "mapgen/WindField.hpp"
+
+// Recomputes humidity and temperature for a new wind on a copy of the
+// regions, on its own thread. The live map is only read while the job runs,
+// so it stays on screen; apply() writes the results back on the main
+// thread. One job runs at a time and a cancelled one is dropped at its next
+// check, between the libmapgen passes.
+class WeatherJob {
+public:
+  ~WeatherJob();
+  void start(MapGenerator *m, float angle, float force);
+  void cancel();
+  void wait();
+  bool running() const;
+  bool finished() const;
+  std::shared_ptr<WindField> apply();
+
+  sf::Time time;
+
+private:
+  MapGenerator *mapgen = nullptr;
+  std::thread worker;
+  std::atomic<bool> done{false};
+  std::atomic<bool> cancelled{false};
+  float angle = 0.f;
+  float force = 0.f;
+  std::vector<decltype(Region::humidity)> humidity;
+  std::vector<decltype(Region::temperature)> temperature;
+  std::shared_ptr<WindField> field;
+
+  void run();
+};
+
+#endif
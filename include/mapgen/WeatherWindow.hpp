@@ -1,12 +1,29 @@
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/System/Clock.hpp>
 #include "mapgen/Region.hpp"
 #include "mapgen/MapGenerator.hpp"
 #include "mapgen/Painter.hpp"
 
+// Wind sliders. Changes are debounced and handed to the application, which
+// recomputes the weather in the background.
 class WeatherWindow {
 public:
   WeatherWindow(sf::RenderWindow *w, MapGenerator* m);
   void draw(WeatherManager* weather, Painter* painter);
+  bool busy();
+  bool due();
+  void take(float &angle, float &force);
+  void setMapGenerator(MapGenerator *m);
   sf::RenderWindow *window;
   MapGenerator *mapgen;
+  float debounce = 0.15f;
+  // Set by the application while a recompute is running.
+  bool computing = false;
+
+private:
+  bool synced = false;
+  float windAngle = 0.f;
+  float windForce = 0.f;
+  bool dirty = false;
+  sf::Clock changed;
 };
@@ -0,0 +1,31 @@
+#ifndef WIND_FIELD_H_
+#define WIND_FIELD_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/Region.hpp"
+
+// Downwind neighbour of every region as an index table, computed once per
+// map and wind setting in parallel. The wind overlay and particles read it
+// instead of calling getRegionWithDirection per region and frame.
+class WindField {
+public:
+  void build(std::vector<Region *> &regions, float angle, float force,
+             int threads = 0);
+  int indexOf(Region *region) const;
+  bool matches(std::vector<Region *> &regions, float angle, float force) const;
+  std::size_t bytes() const;
+
+  std::vector<int> downwind;
+
+  float angle = 0.f;
+  float force = 0.f;
+  sf::Time buildTime;
+
+private:
+  std::unordered_map<Region *, int> index;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef WIND_PARTICLES_H_
+#define WIND_PARTICLES_H_
+
+#include <memory>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include "mapgen/Random.hpp"
+#include "mapgen/Region.hpp"
+#include "mapgen/WindField.hpp"
+
+// Flow particles advected along the cached downwind table, drawn as one
+// quad batch.
+class WindParticles : public sf::Drawable {
+public:
+  WindParticles();
+  void init(std::shared_ptr<WindField> field, std::vector<Region *> &regions,
+            int count, unsigned int seed);
+  void tick(float dt);
+  void clear();
+  bool uses(std::shared_ptr<WindField> field) const;
+
+  float speed = 30.f;
+  float size = 1.5f;
+
+private:
+  std::shared_ptr<WindField> field;
+  std::vector<sf::Vector2f> sites;
+  std::vector<int> sources;
+  std::vector<int> from;
+  std::vector<float> progress;
+  RandomStream random;
+  std::vector<unsigned int> draws;
+  sf::VertexArray vertices;
+
+  void respawn(int particle);
+  virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+};
+
+#endif
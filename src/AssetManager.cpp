@@ -0,0 +1,263 @@
+#include <fstream>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include "mapgen/AssetManager.hpp"
+#include "mapgen/utils.hpp"
+#include "rang.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+
+namespace {
+const unsigned int PACK_MAGIC = 0x5041474d; // "MGAP"
+const unsigned int PACK_VERSION = 1;
+
+template <typename T> void put(std::ofstream &out, T value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> T get(std::ifstream &in) {
+  T value{};
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return value;
+}
+
+void putString(std::ofstream &out, const std::string &value) {
+  put<unsigned int>(out, value.size());
+  out.write(value.data(), value.size());
+}
+
+std::string getString(std::ifstream &in) {
+  auto size = get<unsigned int>(in);
+  std::string value(size, '\0');
+  in.read(&value[0], size);
+  return value;
+}
+
+void putImage(std::ofstream &out, const sf::Image &image) {
+  auto size = image.getSize();
+  put<unsigned int>(out, size.x);
+  put<unsigned int>(out, size.y);
+  out.write(reinterpret_cast<const char *>(image.getPixelsPtr()),
+            size.x * size.y * 4);
+}
+
+bool getImage(std::ifstream &in, sf::Image &image) {
+  auto w = get<unsigned int>(in);
+  auto h = get<unsigned int>(in);
+  if (!in || w == 0 || h == 0) {
+    return false;
+  }
+  std::vector<sf::Uint8> pixels(w * h * 4);
+  in.read(reinterpret_cast<char *>(pixels.data()), pixels.size());
+  if (!in) {
+    return false;
+  }
+  image.create(w, h, pixels.data());
+  return true;
+}
+
+std::string selfDir() {
+#ifdef _WIN32
+  char buff[MAX_PATH];
+  GetModuleFileName(NULL, buff, sizeof(buff));
+  return fs::path(buff).parent_path().string();
+#else
+  std::error_code ec;
+  auto exe = fs::read_symlink("/proc/self/exe", ec);
+  if (ec) {
+    return fs::current_path().string();
+  }
+  return exe.parent_path().string();
+#endif
+}
+} // namespace
+
+AssetManager::AssetManager() {
+  root = selfDir();
+  packPath = path("assets.pack");
+}
+
+AssetManager::~AssetManager() {
+  if (loader.joinable()) {
+    loader.join();
+  }
+}
+
+std::string AssetManager::path(std::string name) const {
+  return (fs::path(root) / name).string();
+}
+
+std::string AssetManager::readFile(std::string name) const {
+  std::ifstream in(path(name), std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+void AssetManager::preload() {
+  if (loader.joinable()) {
+    return;
+  }
+  loader = std::thread([&]() { load(); });
+}
+
+void AssetManager::wait() {
+  if (loader.joinable()) {
+    loader.join();
+  }
+}
+
+void AssetManager::reportFrame(std::string name) {
+  if (frames.find(name) != frames.end()) {
+    return;
+  }
+  frames[name] = startup.getElapsedTime();
+  std::cout << "time to " << name << ": " << rang::fg::green
+            << frames[name].asMilliseconds() << "ms" << rang::style::reset
+            << '\n';
+}
+
+void AssetManager::load() {
+  sf::Clock clock;
+
+  std::vector<fs::path> files;
+  std::error_code ec;
+  for (auto &d : fs::directory_iterator(path("images"), ec)) {
+    if (d.path().extension() != ".png") {
+      continue;
+    }
+    files.push_back(d.path());
+    mtimes[d.path().stem().string()] =
+        fs::last_write_time(d.path()).time_since_epoch().count();
+  }
+
+  std::map<std::string, long long> packed;
+  bool atlasValid = false;
+  readPack(packed, atlasValid);
+
+  std::vector<fs::path> missing;
+  for (auto &file : files) {
+    auto name = file.stem().string();
+    if (packed.find(name) == packed.end() || packed[name] != mtimes[name]) {
+      missing.push_back(file);
+      images.erase(name);
+    }
+  }
+  for (auto &pair : packed) {
+    if (mtimes.find(pair.first) == mtimes.end()) {
+      images.erase(pair.first);
+    }
+  }
+  atlasValid = atlasValid && missing.size() == 0 && packed.size() == files.size();
+  cached = files.size() - missing.size();
+  decoded = missing.size();
+
+  int nThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::vector<std::pair<std::string, sf::Image>>> results(nThreads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < nThreads && t < int(missing.size()); t++) {
+    workers.push_back(std::thread([&, t]() {
+      for (int i = t; i < int(missing.size()); i += nThreads) {
+        sf::Image image;
+        if (image.loadFromFile(missing[i].string())) {
+          results[t].push_back(std::make_pair(missing[i].stem().string(), image));
+        }
+      }
+    }));
+  }
+
+  font.loadFromFile(path("font.ttf"));
+  shaders["blur"] = readFile("blur.frag");
+  shaders["mask"] = readFile("mask.frag");
+
+  for (auto &w : workers) {
+    w.join();
+  }
+  for (auto &result : results) {
+    for (auto &pair : result) {
+      images[pair.first] = pair.second;
+    }
+  }
+
+  if (!atlasValid) {
+    for (auto &pair : images) {
+      atlas.add(pair.first, pair.second);
+    }
+    atlas.pack(atlasImage);
+  }
+  if (!atlasValid || decoded > 0) {
+    writePack();
+  }
+
+  loadTime = clock.getElapsedTime();
+  mg::info("Assets loaded from pack:", cached);
+  mg::info("Assets decoded:", decoded);
+}
+
+bool AssetManager::readPack(std::map<std::string, long long> &packed,
+                            bool &atlasValid) {
+  std::ifstream in(packPath, std::ios::binary);
+  if (!in || get<unsigned int>(in) != PACK_MAGIC ||
+      get<unsigned int>(in) != PACK_VERSION) {
+    return false;
+  }
+
+  auto count = get<unsigned int>(in);
+  for (unsigned int i = 0; i < count && in; i++) {
+    auto name = getString(in);
+    auto mtime = get<long long>(in);
+    sf::Image image;
+    if (!getImage(in, image)) {
+      return false;
+    }
+    images[name] = image;
+    packed[name] = mtime;
+  }
+
+  auto rects = get<unsigned int>(in);
+  for (unsigned int i = 0; i < rects && in; i++) {
+    auto name = getString(in);
+    int x = get<int>(in);
+    int y = get<int>(in);
+    int w = get<int>(in);
+    int h = get<int>(in);
+    atlas.rects[name] = sf::IntRect(x, y, w, h);
+  }
+  atlasValid = rects > 0 && getImage(in, atlasImage);
+  if (!atlasValid) {
+    atlas.rects.clear();
+  }
+  return bool(in);
+}
+
+void AssetManager::writePack() {
+  std::ofstream out(packPath, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    mg::warn("Cannot write asset pack:", packPath);
+    return;
+  }
+  put<unsigned int>(out, PACK_MAGIC);
+  put<unsigned int>(out, PACK_VERSION);
+
+  put<unsigned int>(out, images.size());
+  for (auto &pair : images) {
+    putString(out, pair.first);
+    put<long long>(out, mtimes[pair.first]);
+    putImage(out, pair.second);
+  }
+
+  put<unsigned int>(out, atlas.rects.size());
+  for (auto &pair : atlas.rects) {
+    putString(out, pair.first);
+    put<int>(out, pair.second.left);
+    put<int>(out, pair.second.top);
+    put<int>(out, pair.second.width);
+    put<int>(out, pair.second.height);
+  }
+  putImage(out, atlasImage);
+}
@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/Delaunay.hpp"
+#include "rang.hpp"
+
+namespace {
+const double EPSILON = std::pow(2.0, -52);
+
+inline std::uint32_t nextHalfedge(std::uint32_t e) {
+  return e % 3 == 2 ? e - 2 : e + 1;
+}
+
+inline double dist(double ax, double ay, double bx, double by) {
+  double dx = ax - bx;
+  double dy = ay - by;
+  return dx * dx + dy * dy;
+}
+
+// Orientation test; every triangle ends up wound the same way.
+inline bool orient(double px, double py, double qx, double qy, double rx,
+                   double ry) {
+  return (qy - py) * (rx - qx) - (qx - px) * (ry - qy) < 0;
+}
+
+inline bool inCircle(double ax, double ay, double bx, double by, double cx,
+                     double cy, double px, double py) {
+  double dx = ax - px;
+  double dy = ay - py;
+  double ex = bx - px;
+  double ey = by - py;
+  double fx = cx - px;
+  double fy = cy - py;
+  double ap = dx * dx + dy * dy;
+  double bp = ex * ex + ey * ey;
+  double cp = fx * fx + fy * fy;
+  return dx * (ey * cp - bp * fy) - dy * (ex * cp - bp * fx) +
+             ap * (ex * fy - ey * fx) <
+         0;
+}
+
+// Circumcentre offset from a, as (x, y).
+inline void circumOffset(double ax, double ay, double bx, double by, double cx,
+                         double cy, double &x, double &y) {
+  double dx = bx - ax;
+  double dy = by - ay;
+  double ex = cx - ax;
+  double ey = cy - ay;
+  double bl = dx * dx + dy * dy;
+  double cl = ex * ex + ey * ey;
+  double d = 0.5 / (dx * ey - dy * ex);
+  x = (ey * bl - dy * cl) * d;
+  y = (dx * cl - ex * bl) * d;
+}
+
+inline double circumradius(double ax, double ay, double bx, double by,
+                           double cx, double cy) {
+  double x, y;
+  circumOffset(ax, ay, bx, by, cx, cy, x, y);
+  double r = x * x + y * y;
+  return std::isfinite(r) ? r : std::numeric_limits<double>::infinity();
+}
+
+// Monotonic in the angle of (dx, dy), in [0, 1).
+inline double pseudoAngle(double dx, double dy) {
+  double p = dx / (std::abs(dx) + std::abs(dy));
+  return (dy > 0 ? 3 - p : 1 + p) / 4;
+}
+} // namespace
+
+void Delaunay::build(const std::vector<double> &c) {
+  coords = c;
+  std::uint32_t n = std::uint32_t(coords.size() / 2);
+  triangles.clear();
+  halfedges.clear();
+  hull.clear();
+  if (n < 3) {
+    return;
+  }
+
+  double minX = std::numeric_limits<double>::infinity();
+  double minY = minX;
+  double maxX = -minX;
+  double maxY = -minX;
+  std::vector<std::uint32_t> ids(n);
+  for (std::uint32_t i = 0; i < n; i++) {
+    minX = std::min(minX, coords[2 * i]);
+    minY = std::min(minY, coords[2 * i + 1]);
+    maxX = std::max(maxX, coords[2 * i]);
+    maxY = std::max(maxY, coords[2 * i + 1]);
+    ids[i] = i;
+  }
+  double mx = (minX + maxX) / 2;
+  double my = (minY + maxY) / 2;
+
+  // Seed triangle: the site nearest the centre, its nearest neighbour and
+  // the site forming the smallest circumcircle with both.
+  std::uint32_t i0 = 0, i1 = 0, i2 = 0;
+  double best = std::numeric_limits<double>::infinity();
+  for (std::uint32_t i = 0; i < n; i++) {
+    double d = dist(mx, my, coords[2 * i], coords[2 * i + 1]);
+    if (d < best) {
+      i0 = i;
+      best = d;
+    }
+  }
+  best = std::numeric_limits<double>::infinity();
+  for (std::uint32_t i = 0; i < n; i++) {
+    double d = dist(coords[2 * i0], coords[2 * i0 + 1], coords[2 * i],
+                    coords[2 * i + 1]);
+    if (i != i0 && d < best && d > 0) {
+      i1 = i;
+      best = d;
+    }
+  }
+  best = std::numeric_limits<double>::infinity();
+  for (std::uint32_t i = 0; i < n; i++) {
+    if (i == i0 || i == i1) {
+      continue;
+    }
+    double r = circumradius(coords[2 * i0], coords[2 * i0 + 1],
+                            coords[2 * i1], coords[2 * i1 + 1],
+                            coords[2 * i], coords[2 * i + 1]);
+    if (r < best) {
+      i2 = i;
+      best = r;
+    }
+  }
+  if (best == std::numeric_limits<double>::infinity()) {
+    // All sites are collinear: no triangles, the hull is the sorted line.
+    std::sort(ids.begin(), ids.end(), [&](std::uint32_t a, std::uint32_t b) {
+      return coords[2 * a] != coords[2 * b] ? coords[2 * a] < coords[2 * b]
+                                            : coords[2 * a + 1] <
+                                                  coords[2 * b + 1];
+    });
+    hull = ids;
+    return;
+  }
+  if (orient(coords[2 * i0], coords[2 * i0 + 1], coords[2 * i1],
+             coords[2 * i1 + 1], coords[2 * i2], coords[2 * i2 + 1])) {
+    std::swap(i1, i2);
+  }
+  double ox, oy;
+  circumOffset(coords[2 * i0], coords[2 * i0 + 1], coords[2 * i1],
+               coords[2 * i1 + 1], coords[2 * i2], coords[2 * i2 + 1], ox, oy);
+  cx = coords[2 * i0] + ox;
+  cy = coords[2 * i0 + 1] + oy;
+
+  std::vector<double> dists(n);
+  for (std::uint32_t i = 0; i < n; i++) {
+    dists[i] = dist(coords[2 * i], coords[2 * i + 1], cx, cy);
+  }
+  std::sort(ids.begin(), ids.end(), [&](std::uint32_t a, std::uint32_t b) {
+    return dists[a] < dists[b];
+  });
+
+  std::size_t maxTriangles = std::max<std::size_t>(2 * n, 5) - 5;
+  triangles.reserve(maxTriangles * 3);
+  halfedges.reserve(maxTriangles * 3);
+  hullPrev.assign(n, 0);
+  hullNext.assign(n, 0);
+  hullTri.assign(n, 0);
+  hullHash.assign(std::size_t(std::ceil(std::sqrt(double(n)))), -1);
+  edgeStack.clear();
+
+  hullStart = i0;
+  std::size_t hullSize = 3;
+  hullNext[i0] = hullPrev[i2] = i1;
+  hullNext[i1] = hullPrev[i0] = i2;
+  hullNext[i2] = hullPrev[i1] = i0;
+  hullTri[i0] = 0;
+  hullTri[i1] = 1;
+  hullTri[i2] = 2;
+  hullHash[hashKey(coords[2 * i0], coords[2 * i0 + 1])] = i0;
+  hullHash[hashKey(coords[2 * i1], coords[2 * i1 + 1])] = i1;
+  hullHash[hashKey(coords[2 * i2], coords[2 * i2 + 1])] = i2;
+  addTriangle(i0, i1, i2, -1, -1, -1);
+
+  double xp = 0, yp = 0;
+  for (std::uint32_t k = 0; k < n; k++) {
+    std::uint32_t i = ids[k];
+    double x = coords[2 * i];
+    double y = coords[2 * i + 1];
+    if (k > 0 && std::abs(x - xp) <= EPSILON && std::abs(y - yp) <= EPSILON) {
+      continue;
+    }
+    xp = x;
+    yp = y;
+    if (i == i0 || i == i1 || i == i2) {
+      continue;
+    }
+
+    // A visible hull edge, found through the angular hash.
+    std::uint32_t start = 0;
+    std::size_t key = hashKey(x, y);
+    for (std::size_t j = 0; j < hullHash.size(); j++) {
+      auto s = hullHash[(key + j) % hullHash.size()];
+      if (s != -1 && std::uint32_t(s) != hullNext[s]) {
+        start = std::uint32_t(s);
+        break;
+      }
+    }
+    start = hullPrev[start];
+    std::int64_t e = start;
+    std::uint32_t q;
+    while (q = hullNext[e],
+           !orient(x, y, coords[2 * e], coords[2 * e + 1], coords[2 * q],
+                   coords[2 * q + 1])) {
+      e = q;
+      if (e == start) {
+        e = -1;
+        break;
+      }
+    }
+    if (e == -1) {
+      continue; // near-duplicate site
+    }
+
+    std::uint32_t t = addTriangle(std::uint32_t(e), i, hullNext[e], -1, -1,
+                                  std::int32_t(hullTri[e]));
+    hullTri[i] = legalize(t + 2);
+    hullTri[e] = t;
+    hullSize++;
+
+    std::uint32_t m = hullNext[e];
+    while (q = hullNext[m], orient(x, y, coords[2 * m], coords[2 * m + 1],
+                                   coords[2 * q], coords[2 * q + 1])) {
+      t = addTriangle(m, i, q, std::int32_t(hullTri[i]), -1,
+                      std::int32_t(hullTri[m]));
+      hullTri[i] = legalize(t + 2);
+      hullNext[m] = m;
+      hullSize--;
+      m = q;
+    }
+    if (e == start) {
+      while (q = hullPrev[e], orient(x, y, coords[2 * q], coords[2 * q + 1],
+                                     coords[2 * e], coords[2 * e + 1])) {
+        t = addTriangle(q, i, std::uint32_t(e), -1, std::int32_t(hullTri[e]),
+                        std::int32_t(hullTri[q]));
+        legalize(t + 2);
+        hullTri[q] = t;
+        hullNext[e] = std::uint32_t(e);
+        hullSize--;
+        e = q;
+      }
+    }
+
+    hullStart = hullPrev[i] = std::uint32_t(e);
+    hullNext[e] = hullPrev[m] = i;
+    hullNext[i] = m;
+    hullHash[hashKey(x, y)] = std::int32_t(i);
+    hullHash[hashKey(coords[2 * e], coords[2 * e + 1])] = std::int32_t(e);
+  }
+
+  hull.reserve(hullSize);
+  for (std::uint32_t i = 0, e = hullStart; i < hullSize; i++) {
+    hull.push_back(e);
+    e = hullNext[e];
+  }
+}
+
+std::size_t Delaunay::hashKey(double x, double y) const {
+  auto size = hullHash.size();
+  return std::size_t(std::floor(pseudoAngle(x - cx, y - cy) * size)) % size;
+}
+
+void Delaunay::link(std::int32_t a, std::int32_t b) {
+  halfedges[a] = b;
+  if (b != -1) {
+    halfedges[b] = a;
+  }
+}
+
+std::uint32_t Delaunay::addTriangle(std::uint32_t i0, std::uint32_t i1,
+                                    std::uint32_t i2, std::int32_t a,
+                                    std::int32_t b, std::int32_t c) {
+  auto t = std::uint32_t(triangles.size());
+  triangles.push_back(i0);
+  triangles.push_back(i1);
+  triangles.push_back(i2);
+  halfedges.resize(t + 3, -1);
+  link(std::int32_t(t), a);
+  link(std::int32_t(t + 1), b);
+  link(std::int32_t(t + 2), c);
+  return t;
+}
+
+// Flips edges around a new triangle until they are all locally Delaunay;
+// returns the half-edge that ends on the hull.
+std::uint32_t Delaunay::legalize(std::uint32_t a) {
+  std::uint32_t ar = 0;
+  while (true) {
+    std::int32_t b = halfedges[a];
+    std::uint32_t a0 = a - a % 3;
+    ar = a0 + (a + 2) % 3;
+    if (b == -1) {
+      if (edgeStack.empty()) {
+        break;
+      }
+      a = edgeStack.back();
+      edgeStack.pop_back();
+      continue;
+    }
+
+    std::uint32_t b0 = std::uint32_t(b) - std::uint32_t(b) % 3;
+    std::uint32_t al = a0 + (a + 1) % 3;
+    std::uint32_t bl = b0 + (std::uint32_t(b) + 2) % 3;
+    std::uint32_t p0 = triangles[ar];
+    std::uint32_t pr = triangles[a];
+    std::uint32_t pl = triangles[al];
+    std::uint32_t p1 = triangles[bl];
+    if (inCircle(coords[2 * p0], coords[2 * p0 + 1], coords[2 * pr],
+                 coords[2 * pr + 1], coords[2 * pl], coords[2 * pl + 1],
+                 coords[2 * p1], coords[2 * p1 + 1])) {
+      triangles[a] = p1;
+      triangles[b] = p0;
+      std::int32_t hbl = halfedges[bl];
+      if (hbl == -1) {
+        // The flipped edge was on the hull: fix its hull triangle.
+        std::uint32_t e = hullStart;
+        do {
+          if (hullTri[e] == bl) {
+            hullTri[e] = a;
+            break;
+          }
+          e = hullPrev[e];
+        } while (e != hullStart);
+      }
+      link(std::int32_t(a), hbl);
+      link(b, halfedges[ar]);
+      link(std::int32_t(ar), std::int32_t(bl));
+      edgeStack.push_back(b0 + (std::uint32_t(b) + 1) % 3);
+    } else {
+      if (edgeStack.empty()) {
+        break;
+      }
+      a = edgeStack.back();
+      edgeStack.pop_back();
+    }
+  }
+  return ar;
+}
+
+// Voronoi cells are the circumcentres of the triangles around each site,
+// in order; cells of hull sites stay open. Neighbours are the sites across
+// the cell edges.
+void Delaunay::fill(RegionStore &store) const {
+  store.clear();
+  std::uint32_t n = std::uint32_t(size());
+  std::uint32_t count = std::uint32_t(triangles.size());
+
+  std::vector<float> ccx(count / 3);
+  std::vector<float> ccy(count / 3);
+  for (std::uint32_t t = 0; t < count / 3; t++) {
+    auto a = triangles[3 * t];
+    auto b = triangles[3 * t + 1];
+    auto c = triangles[3 * t + 2];
+    double x, y;
+    circumOffset(coords[2 * a], coords[2 * a + 1], coords[2 * b],
+                 coords[2 * b + 1], coords[2 * c], coords[2 * c + 1], x, y);
+    ccx[t] = float(coords[2 * a] + x);
+    ccy[t] = float(coords[2 * a + 1] + y);
+  }
+
+  // One incoming half-edge per site, a hull one where there is one, so the
+  // walk around an open cell starts at its border.
+  std::vector<std::int32_t> inedge(n, -1);
+  for (std::uint32_t e = 0; e < count; e++) {
+    auto p = triangles[nextHalfedge(e)];
+    if (halfedges[e] == -1 || inedge[p] == -1) {
+      inedge[p] = std::int32_t(e);
+    }
+  }
+
+  store.x.resize(n);
+  store.y.resize(n);
+  store.cluster.assign(n, UINT32_MAX);
+  store.land.assign(n, 0);
+  store.vertexStart.reserve(n + 1);
+  store.neighborStart.reserve(n + 1);
+  store.vx.reserve(count);
+  store.vy.reserve(count);
+  store.neighbors.reserve(count);
+  store.vertexStart.push_back(0);
+  store.neighborStart.push_back(0);
+  for (std::uint32_t p = 0; p < n; p++) {
+    store.x[p] = float(coords[2 * p]);
+    store.y[p] = float(coords[2 * p + 1]);
+    std::int32_t e0 = inedge[p];
+    if (e0 != -1) {
+      std::int32_t e = e0;
+      do {
+        auto t = std::uint32_t(e) / 3;
+        store.vx.push_back(ccx[t]);
+        store.vy.push_back(ccy[t]);
+        store.neighbors.push_back(triangles[e]);
+        auto out = nextHalfedge(std::uint32_t(e));
+        if (triangles[out] != p) {
+          break;
+        }
+        e = halfedges[out];
+        if (e == -1) {
+          store.neighbors.push_back(triangles[nextHalfedge(out)]);
+        }
+      } while (e != e0 && e != -1);
+    }
+    store.vertexStart.push_back(std::uint32_t(store.vx.size()));
+    store.neighborStart.push_back(std::uint32_t(store.neighbors.size()));
+  }
+}
+
+std::size_t Delaunay::size() const { return coords.size() / 2; }
+
+std::size_t Delaunay::bytes() const {
+  return coords.capacity() * sizeof(double) +
+         (triangles.capacity() + halfedges.capacity() + hull.capacity() +
+          hullPrev.capacity() + hullNext.capacity() + hullTri.capacity() +
+          hullHash.capacity() + edgeStack.capacity()) *
+             sizeof(std::uint32_t);
+}
+
+// Uniform random sites in a 1000x1000 square, as the map generator lays
+// them out before relaxation.
+void Delaunay::benchmark() {
+  for (int n : {10000, 100000, 1000000}) {
+    std::mt19937 rng(n);
+    std::uniform_real_distribution<double> uniform(0.0, 1000.0);
+    std::vector<double> sites(2 * n);
+    for (auto &v : sites) {
+      v = uniform(rng);
+    }
+
+    sf::Clock clock;
+    Delaunay delaunay;
+    delaunay.build(sites);
+    auto triangulate = clock.restart().asMicroseconds() / 1000.f;
+    RegionStore store;
+    delaunay.fill(store);
+    auto cells = clock.restart().asMicroseconds() / 1000.f;
+
+    std::cout << "diagram " << n << " sites, "
+              << delaunay.triangles.size() / 3 << " triangles: triangulate "
+              << rang::fg::green << triangulate << "ms" << rang::style::reset
+              << ", cells " << rang::fg::green << cells << "ms"
+              << rang::style::reset << ", triangulation "
+              << delaunay.bytes() / 1024 / 1024 << "MB, region store "
+              << store.bytes() / 1024 / 1024 << "MB" << '\n';
+  }
+}
@@ -0,0 +1,102 @@
+#include <thread>
+
+#include "mapgen/DeterminismCheck.hpp"
+#include "mapgen/HeightCache.hpp"
+#include "mapgen/HeightRaster.hpp"
+#include "mapgen/MapHasher.hpp"
+#include "mapgen/PathService.hpp"
+#include "mapgen/WindField.hpp"
+#include "mapgen/utils.hpp"
+
+DeterminismCheck::DeterminismCheck(MapGenerator *m) : mapgen(m) {}
+
+void DeterminismCheck::setMapGenerator(MapGenerator *m) {
+  mapgen = m;
+  results.clear();
+  done = false;
+}
+
+// Runs on the generator thread; the map is regenerated in place, so the
+// caller has to rebuild everything derived from it afterwards. The map
+// stages come from two fresh generations, never from the live map, which
+// simulation and wind edits change after generation.
+bool DeterminismCheck::run(int threads) {
+  if (threads <= 0) {
+    threads = std::max(2u, std::thread::hardware_concurrency());
+  }
+  results.clear();
+
+  MapHasher first(mapgen), second(mapgen);
+  mapgen->update();
+  first.hash(nullptr, threads);
+  mapgen->update();
+  second.hash(nullptr, threads);
+  for (int s = 0; s < MapHasher::STAGES; s++) {
+    results.push_back(StageResult{std::string("map ") + MapHasher::names[s] +
+                                      " (run to run)",
+                                  first.stages[s], second.stages[s]});
+  }
+
+  auto &regions = mapgen->map->regions;
+  {
+    HeightCache a, b;
+    a.build(regions, 1);
+    b.build(regions, threads);
+    ContentHash ha, hb;
+    ha.add(a.siteHeight);
+    ha.add(a.vertexHeight);
+    hb.add(b.siteHeight);
+    hb.add(b.vertexHeight);
+    results.push_back(StageResult{"height cache", ha.value, hb.value});
+  }
+
+  if (!regions.empty()) {
+    HeightRaster a, b;
+    a.bake(regions[0], 1000.f, 1000.f, 256, 1);
+    b.bake(regions[0], 1000.f, 1000.f, 256, threads);
+    ContentHash ha, hb;
+    ha.add(a.data);
+    hb.add(b.data);
+    results.push_back(StageResult{"height raster", ha.value, hb.value});
+  }
+
+  {
+    auto weather = mapgen->weather;
+    WindField a, b;
+    a.build(regions, weather->windAngle, weather->windForce, 1);
+    b.build(regions, weather->windAngle, weather->windForce, threads);
+    ContentHash ha, hb;
+    ha.add(a.downwind);
+    hb.add(b.downwind);
+    results.push_back(StageResult{"wind field", ha.value, hb.value});
+  }
+
+  {
+    PathService a, b;
+    a.build(regions, mapgen->map->clusters);
+    b.build(regions, mapgen->map->clusters);
+    auto queries = a.cityPairs(mapgen->map->cities, LAND_ROUTE);
+    if (queries.size() > 64) {
+      queries.resize(64);
+    }
+    ContentHash ha, hb;
+    for (auto &path : a.routeAll(queries, 1)) {
+      ha.add(path);
+    }
+    for (auto &path : b.routeAll(queries, threads)) {
+      hb.add(path);
+    }
+    results.push_back(StageResult{"routes", ha.value, hb.value});
+  }
+
+  passed = true;
+  for (auto &r : results) {
+    if (r.reference != r.candidate) {
+      passed = false;
+      mg::warn("Determinism check failed:", r.name);
+    }
+  }
+  done = true;
+  mg::info("Determinism check threads:", threads);
+  return passed;
+}
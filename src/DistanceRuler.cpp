@@ -0,0 +1,201 @@
+#include <cmath>
+#include <functional>
+#include <queue>
+
+#include "mapgen/DistanceRuler.hpp"
+#include "mapgen/MapGenerator.hpp"
+#include "mapgen/RegionGraph.hpp"
+#include "mapgen/utils.hpp"
+
+namespace {
+sf::Vector2f position(Region *region) {
+  return sf::Vector2f(static_cast<float>(region->site->x),
+                      static_cast<float>(region->site->y));
+}
+} // namespace
+
+void DistanceRuler::setOrigin(Region *o, Map *map, sf::Font &font) {
+  sf::Clock clock;
+  clear();
+  origin = o;
+  regions = map->regions;
+  index.reserve(regions.size());
+  for (int i = 0; i < int(regions.size()); i++) {
+    index[regions[i]] = i;
+  }
+  int n = int(regions.size());
+  auto start = index.find(origin);
+  if (start == index.end()) {
+    clear();
+    return;
+  }
+
+  // Road network: consecutive regions of every road and sea path. Regions
+  // outside the map are skipped.
+  std::vector<std::vector<std::pair<int, float>>> edges(n);
+  for (auto &pair : map->roadMap) {
+    auto &path = pair.second->regions;
+    for (int i = 1; i < int(path.size()); i++) {
+      auto ia = index.find(path[i - 1]);
+      auto ib = index.find(path[i]);
+      if (ia == index.end() || ib == index.end()) {
+        continue;
+      }
+      int a = ia->second;
+      int b = ib->second;
+      float d = mg::getDistance(path[i - 1]->site, path[i]->site);
+      edges[a].push_back(std::make_pair(b, d));
+      edges[b].push_back(std::make_pair(a, d));
+    }
+  }
+  dijkstra(roads, start->second, edges);
+
+  RegionGraph graph(LAND_ROUTE);
+  graph.heights = heights;
+  for (int i = 0; i < n; i++) {
+    edges[i].clear();
+    if (!graph.passable(regions[i])) {
+      continue;
+    }
+    for (auto neighbor : regions[i]->neighbors) {
+      auto it = index.find(neighbor);
+      if (it != index.end() && graph.passable(neighbor)) {
+        edges[i].push_back(
+            std::make_pair(it->second, graph.cost(regions[i], neighbor)));
+      }
+    }
+  }
+  dijkstra(land, start->second, edges);
+
+  PointList points = origin->getPoints();
+  originShape.setPointCount(int(points.size()));
+  for (int pi = 0; pi < int(points.size()); pi++) {
+    Point p = points[pi];
+    originShape.setPoint(pi, sf::Vector2f(static_cast<float>(p->x),
+                                          static_cast<float>(p->y)));
+  }
+  originShape.setFillColor(sf::Color::Transparent);
+  originShape.setOutlineColor(sf::Color::Black);
+  originShape.setOutlineThickness(2);
+
+  originSite.setRadius(2.f);
+  originSite.setFillColor(sf::Color::Red);
+  originSite.setPosition(position(origin) - sf::Vector2f(1.f, 1.f));
+
+  labelBg.setFillColor(sf::Color::Black);
+  labelBg.setOutlineColor(sf::Color(30, 30, 30));
+  labelBg.setOutlineThickness(1);
+  label.setFont(font);
+  label.setCharacterSize(15);
+  label.setFillColor(sf::Color::White);
+
+  buildTime = clock.getElapsedTime();
+}
+
+void DistanceRuler::dijkstra(
+    Tree &tree, int source,
+    const std::vector<std::vector<std::pair<int, float>>> &edges) {
+  int n = int(edges.size());
+  tree.cost.assign(n, -1.f);
+  tree.length.assign(n, 0.f);
+  tree.parent.assign(n, -1);
+
+  typedef std::pair<float, int> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+  tree.cost[source] = 0.f;
+  open.push(Entry(0.f, source));
+  while (!open.empty()) {
+    auto top = open.top();
+    open.pop();
+    int r = top.second;
+    if (top.first > tree.cost[r]) {
+      continue;
+    }
+    for (auto &e : edges[r]) {
+      float g = tree.cost[r] + e.second;
+      if (tree.cost[e.first] < 0.f || g < tree.cost[e.first]) {
+        tree.cost[e.first] = g;
+        tree.parent[e.first] = r;
+        tree.length[e.first] =
+            tree.length[r] +
+            mg::getDistance(regions[r]->site, regions[e.first]->site);
+        open.push(Entry(g, e.first));
+      }
+    }
+  }
+}
+
+// Fills the route polyline and returns its length, or -1 if unreachable.
+float DistanceRuler::walk(const Tree &tree, int to, sf::VertexArray &route,
+                          sf::Color color) const {
+  route.clear();
+  route.setPrimitiveType(sf::LineStrip);
+  if (tree.cost[to] < 0.f) {
+    return -1.f;
+  }
+  for (int r = to; r != -1; r = tree.parent[r]) {
+    route.append(sf::Vertex(position(regions[r]), color));
+  }
+  return tree.length[to];
+}
+
+// Everything is rebuilt only when the hovered region changes.
+void DistanceRuler::hover(Region *t) {
+  if (origin == nullptr || t == target) {
+    return;
+  }
+  target = t;
+  auto it = index.find(target);
+  if (it == index.end()) {
+    return;
+  }
+
+  straight = mg::getDistance(origin->site, target->site);
+  network = walk(roads, it->second, roadRoute, sf::Color(70, 20, 0));
+  terrain = walk(land, it->second, landRoute, sf::Color(200, 40, 40));
+
+  straightLine.clear();
+  straightLine.setPrimitiveType(sf::Lines);
+  straightLine.append(sf::Vertex(position(origin), sf::Color::Red));
+  straightLine.append(sf::Vertex(position(target), sf::Color::Black));
+
+  char mt[120];
+  int len = sprintf(mt, "%.0f", straight);
+  len += network < 0.f ? sprintf(mt + len, " | roads: -")
+                       : sprintf(mt + len, " | roads: %.0f", network);
+  if (terrain < 0.f) {
+    sprintf(mt + len, " | land: -");
+  } else {
+    sprintf(mt + len, " | land: %.0f (cost %.0f)", terrain,
+            land.cost[it->second]);
+  }
+  label.setString(mt);
+  label.setPosition(position(target) + sf::Vector2f(15.f, 15.f));
+  labelBg.setSize(sf::Vector2f(label.getGlobalBounds().width + 8, 18));
+  labelBg.setPosition(position(target) + sf::Vector2f(11.f, 15.f));
+}
+
+void DistanceRuler::clear() {
+  origin = nullptr;
+  target = nullptr;
+  regions.clear();
+  index.clear();
+  roadRoute.clear();
+  landRoute.clear();
+  straightLine.clear();
+}
+
+void DistanceRuler::draw(sf::RenderTarget &rt, sf::RenderStates states) const {
+  if (origin == nullptr) {
+    return;
+  }
+  rt.draw(originShape, states);
+  rt.draw(originSite, states);
+  rt.draw(straightLine, states);
+  rt.draw(landRoute, states);
+  rt.draw(roadRoute, states);
+  if (target != nullptr) {
+    rt.draw(labelBg, states);
+    rt.draw(label, states);
+  }
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "mapgen/FrameScheduler.hpp"
+
+FrameScheduler::FrameScheduler(int h)
+    : history(h), frameTimes(h, 0.f), cpuTimes(h, 0.f), presentTimes(h, 0.f) {}
+
+void FrameScheduler::beginFrame() {
+  frameClock.restart();
+}
+
+void FrameScheduler::endCpu() {
+  cpuTime = frameClock.getElapsedTime().asMicroseconds() / 1000.f;
+  presentClock.restart();
+}
+
+void FrameScheduler::endFrame() {
+  frameTimes[cursor] = frameClock.getElapsedTime().asMicroseconds() / 1000.f;
+  cpuTimes[cursor] = cpuTime;
+  presentTimes[cursor] = presentClock.getElapsedTime().asMicroseconds() / 1000.f;
+  cursor = (cursor + 1) % history;
+  samples = std::min(samples + 1, history);
+}
+
+// Queued tasks with the same name are replaced, so repeated requests
+// (e.g. hovering over many regions) only keep the latest one.
+void FrameScheduler::defer(std::string name, std::function<void()> task) {
+  tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+                             [&](const Task &t) { return t.name == name; }),
+              tasks.end());
+  tasks.push_back(Task{name, task});
+}
+
+// At least one task runs per frame, so work always makes progress.
+void FrameScheduler::runDeferred() {
+  bool first = true;
+  while (!tasks.empty()) {
+    float elapsed = frameClock.getElapsedTime().asMicroseconds() / 1000.f;
+    if (!first && elapsed > budget) {
+      break;
+    }
+    auto task = tasks.front();
+    tasks.pop_front();
+    task.run();
+    first = false;
+  }
+}
+
+void FrameScheduler::clear() { tasks.clear(); }
+
+bool FrameScheduler::pending() const { return !tasks.empty(); }
+
+int FrameScheduler::deferred() const { return int(tasks.size()); }
+
+float FrameScheduler::pick(const std::vector<float> &times, float p) const {
+  if (samples == 0) {
+    return 0.f;
+  }
+  std::vector<float> sorted(times.begin(), times.begin() + samples);
+  int n = std::min(samples - 1, int(p * samples));
+  std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+  return sorted[n];
+}
+
+float FrameScheduler::percentile(float p) const { return pick(frameTimes, p); }
+
+float FrameScheduler::cpuPercentile(float p) const { return pick(cpuTimes, p); }
+
+float FrameScheduler::presentPercentile(float p) const {
+  return pick(presentTimes, p);
+}
@@ -0,0 +1,115 @@
+#include "mapgen/HeightCache.hpp"
+#include "mapgen/Parallel.hpp"
+#include "mapgen/StageCache.hpp"
+
+// Region::getHeight samples the noise module of the map; every point is
+// evaluated by the region that owns it. Batches call it from several
+// threads at once, which relies on the noise module being read-only during
+// evaluation (no lazily built tables, no shared scratch state). The
+// "height cache" stage of DeterminismCheck builds the cache with 1 and N
+// threads and compares the results, so a libmapgen version that breaks
+// this shows up there.
+void HeightCache::sample(const std::vector<Region *> &owners,
+                         const std::vector<Point> &points,
+                         std::vector<float> &out, int threads) {
+  out.resize(points.size());
+  parallelFor(int(points.size()),
+              [&](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                  out[i] = owners[i]->getHeight(points[i]);
+                }
+              },
+              threads, 256);
+}
+
+void HeightCache::build(std::vector<Region *> &regions, int threads) {
+  sf::Clock clock;
+  clear();
+  int n = int(regions.size());
+  index.reserve(n);
+
+  std::vector<Region *> owners(n);
+  std::vector<Point> points(n);
+  std::vector<Region *> vertexOwners;
+  std::vector<Point> vertices;
+  vertexStart.push_back(0);
+  for (int i = 0; i < n; i++) {
+    index[regions[i]] = i;
+    owners[i] = regions[i];
+    points[i] = regions[i]->site;
+    for (auto p : regions[i]->getPoints()) {
+      vertexOwners.push_back(regions[i]);
+      vertices.push_back(p);
+    }
+    vertexStart.push_back(int(vertices.size()));
+  }
+
+  sample(owners, points, siteHeight, threads);
+  sample(vertexOwners, vertices, vertexHeight, threads);
+  buildTime = clock.getElapsedTime();
+}
+
+void HeightCache::clear() {
+  index.clear();
+  siteHeight.clear();
+  vertexStart.clear();
+  vertexHeight.clear();
+}
+
+bool HeightCache::ready() const { return !siteHeight.empty(); }
+
+void HeightCache::write(std::ostream &out) const {
+  StageCache::putVector(out, siteHeight);
+  StageCache::putVector(out, vertexStart);
+  StageCache::putVector(out, vertexHeight);
+}
+
+// Arrays are in map order, so only their sizes are checked against the
+// regions before the index is rebuilt. The vertex offsets bound the size
+// of the vertex heights.
+bool HeightCache::read(std::istream &in, std::vector<Region *> &regions) {
+  sf::Clock clock;
+  clear();
+  int n = int(regions.size());
+  if (!StageCache::getVector(in, siteHeight, n) ||
+      !StageCache::getVector(in, vertexStart, n + 1) ||
+      int(siteHeight.size()) != n || int(vertexStart.size()) != n + 1 ||
+      vertexStart.back() < 0 ||
+      !StageCache::getVector(in, vertexHeight, vertexStart.back()) ||
+      vertexStart.back() != int(vertexHeight.size())) {
+    clear();
+    return false;
+  }
+  index.reserve(n);
+  for (int i = 0; i < n; i++) {
+    index[regions[i]] = i;
+  }
+  buildTime = clock.getElapsedTime();
+  return true;
+}
+
+std::size_t HeightCache::bytes() const {
+  return (siteHeight.capacity() + vertexHeight.capacity()) * sizeof(float) +
+         vertexStart.capacity() * sizeof(int) +
+         index.size() * (sizeof(Region *) + sizeof(int) + 16);
+}
+
+int HeightCache::indexOf(Region *region) const {
+  auto it = index.find(region);
+  return it == index.end() ? -1 : it->second;
+}
+
+// Regions outside the cache (e.g. a map being regenerated) fall back to
+// sampling the noise directly.
+float HeightCache::site(Region *region) const {
+  int i = indexOf(region);
+  return i < 0 ? region->getHeight(region->site) : siteHeight[i];
+}
+
+float HeightCache::vertex(Region *region, int v) const {
+  int i = indexOf(region);
+  if (i < 0 || v >= vertexStart[i + 1] - vertexStart[i]) {
+    return region->getHeight(region->getPoints()[v]);
+  }
+  return vertexHeight[vertexStart[i] + v];
+}
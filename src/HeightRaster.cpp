@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#include "mapgen/HeightRaster.hpp"
+#include "mapgen/Parallel.hpp"
+#include "mapgen/StageCache.hpp"
+#include "rang.hpp"
+
+const int HeightRaster::maxSide;
+
+// Region::getHeight only depends on the point, so one region samples the
+// whole map, tile by tile.
+void HeightRaster::bake(Region *sampler, float w, float h, int resolution,
+                        int threads) {
+  sf::Clock clock;
+  mapWidth = w;
+  mapHeight = h;
+  float scale = resolution / std::max(w, h);
+  width = std::max(2, int(w * scale));
+  height = std::max(2, int(h * scale));
+  data.assign(width * height, 0.f);
+
+  int tilesX = (width + tile - 1) / tile;
+  int tilesY = (height + tile - 1) / tile;
+  parallelFor(tilesX * tilesY,
+              [&](int begin, int end) {
+                for (int t = begin; t < end; t++) {
+                  int x0 = (t % tilesX) * tile;
+                  int y0 = (t / tilesX) * tile;
+                  for (int y = y0; y < std::min(height, y0 + tile); y++) {
+                    for (int x = x0; x < std::min(width, x0 + tile); x++) {
+                      sf::Vector2<double> p(double(x) * w / (width - 1),
+                                            double(y) * h / (height - 1));
+                      data[y * width + x] = sampler->getHeight(&p);
+                    }
+                  }
+                }
+              },
+              threads, 1);
+
+  auto range = std::minmax_element(data.begin(), data.end());
+  minHeight = *range.first;
+  maxHeight = *range.second;
+  bakeTime = clock.getElapsedTime();
+}
+
+void HeightRaster::clear() {
+  data.clear();
+  width = 0;
+  height = 0;
+}
+
+bool HeightRaster::ready() const { return !data.empty(); }
+
+void HeightRaster::write(std::ostream &out) const {
+  StageCache::put(out, width);
+  StageCache::put(out, height);
+  StageCache::put(out, mapWidth);
+  StageCache::put(out, mapHeight);
+  StageCache::putVector(out, data);
+}
+
+bool HeightRaster::read(std::istream &in) {
+  sf::Clock clock;
+  width = StageCache::get<int>(in);
+  height = StageCache::get<int>(in);
+  mapWidth = StageCache::get<float>(in);
+  mapHeight = StageCache::get<float>(in);
+  if (!in || width < 2 || height < 2 || width > maxSide ||
+      height > maxSide ||
+      !StageCache::getVector(in, data, std::size_t(width) * height) ||
+      data.size() != std::size_t(width) * height) {
+    clear();
+    return false;
+  }
+  auto range = std::minmax_element(data.begin(), data.end());
+  minHeight = *range.first;
+  maxHeight = *range.second;
+  bakeTime = clock.getElapsedTime();
+  return true;
+}
+
+std::size_t HeightRaster::bytes() const {
+  return data.capacity() * sizeof(float);
+}
+
+float HeightRaster::at(float x, float y) const {
+  float fx = std::min(std::max(x * (width - 1) / mapWidth, 0.f), width - 1.f);
+  float fy = std::min(std::max(y * (height - 1) / mapHeight, 0.f), height - 1.f);
+  int x0 = std::min(int(fx), width - 2);
+  int y0 = std::min(int(fy), height - 2);
+  float tx = fx - x0;
+  float ty = fy - y0;
+  const float *row = &data[y0 * width + x0];
+  float top = row[0] + (row[1] - row[0]) * tx;
+  float bottom = row[width] + (row[width + 1] - row[width]) * tx;
+  return top + (bottom - top) * ty;
+}
+
+// Hillshade lit from the north-west, as a translucent black/white overlay.
+void HeightRaster::shade(sf::Image &image) const {
+  image.create(width, height, sf::Color::Transparent);
+  float range = std::max(maxHeight - minHeight, 0.0001f);
+  float z = 40.f / range;
+  for (int y = 1; y + 1 < height; y++) {
+    for (int x = 1; x + 1 < width; x++) {
+      float dx = (data[y * width + x + 1] - data[y * width + x - 1]) * z;
+      float dy = (data[(y + 1) * width + x] - data[(y - 1) * width + x]) * z;
+      float light = (-dx - dy + 1.f) / std::sqrt(dx * dx + dy * dy + 1.f) /
+                    std::sqrt(3.f);
+      float v = std::min(std::max(light, -1.f), 1.f);
+      sf::Uint8 alpha = sf::Uint8(std::abs(v - 0.55f) * 160.f);
+      image.setPixel(x, y, v > 0.55f ? sf::Color(255, 255, 255, alpha)
+                                     : sf::Color(0, 0, 0, alpha));
+    }
+  }
+}
+
+// Writes <path>.png (normalised greyscale) and <path>.f32 (width, height
+// as int32, then row-major floats).
+bool HeightRaster::save(std::string path) const {
+  if (!ready()) {
+    return false;
+  }
+  std::ofstream out(path + ".f32", std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(&width), sizeof(width));
+  out.write(reinterpret_cast<const char *>(&height), sizeof(height));
+  out.write(reinterpret_cast<const char *>(data.data()),
+            data.size() * sizeof(float));
+
+  sf::Image image;
+  image.create(width, height);
+  float range = std::max(maxHeight - minHeight, 0.0001f);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      auto v = sf::Uint8(255.f * (data[y * width + x] - minHeight) / range);
+      image.setPixel(x, y, sf::Color(v, v, v));
+    }
+  }
+  return bool(out) && image.saveToFile(path + ".png");
+}
+
+// Error of the bilinear lookup against the noise, and time per sample.
+void HeightRaster::benchmark(Region *sampler, int samples) {
+  if (!ready()) {
+    return;
+  }
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dx(0.f, mapWidth);
+  std::uniform_real_distribution<float> dy(0.f, mapHeight);
+  std::vector<sf::Vector2<double>> points(samples);
+  for (auto &p : points) {
+    p = sf::Vector2<double>(dx(rng), dy(rng));
+  }
+
+  std::vector<float> exact(samples);
+  std::vector<float> approx(samples);
+  sf::Clock clock;
+  for (int i = 0; i < samples; i++) {
+    exact[i] = sampler->getHeight(&points[i]);
+  }
+  noiseNs = clock.restart().asMicroseconds() * 1000.f / samples;
+  for (int i = 0; i < samples; i++) {
+    approx[i] = at(float(points[i].x), float(points[i].y));
+  }
+  rasterNs = clock.restart().asMicroseconds() * 1000.f / samples;
+
+  double sum = 0.0;
+  maxError = 0.f;
+  for (int i = 0; i < samples; i++) {
+    float e = std::abs(exact[i] - approx[i]);
+    sum += e;
+    maxError = std::max(maxError, e);
+  }
+  meanError = float(sum / samples);
+
+  std::cout << "height raster " << width << "x" << height << ": bake "
+            << rang::fg::green << bakeTime.asMilliseconds() << "ms"
+            << rang::style::reset << ", noise " << rang::fg::green << noiseNs
+            << "ns" << rang::style::reset << ", raster " << rang::fg::green
+            << rasterNs << "ns" << rang::style::reset << ", error mean "
+            << meanError << " max " << maxError << '\n';
+}
@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <queue>
+
+#include "mapgen/HierarchicalRouter.hpp"
+#include "mapgen/MapGenerator.hpp"
+
+namespace {
+typedef std::pair<float, int> Entry;
+typedef std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+    OpenList;
+
+float distance(sf::Vector2f a, sf::Vector2f b) {
+  return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+sf::Vector2f position(Region *region) {
+  return sf::Vector2f(float(region->site->x), float(region->site->y));
+}
+} // namespace
+
+void HierarchicalRouter::build(std::vector<Region *> &r,
+                               std::vector<Cluster *> &c) {
+  sf::Clock clock;
+  regions = r;
+  clusters = c;
+
+  std::unordered_map<Cluster *, int> clusterIndex;
+  for (int i = 0; i < int(clusters.size()); i++) {
+    clusterIndex[clusters[i]] = i;
+  }
+  regionIndex.clear();
+  regionCluster.assign(regions.size(), -1);
+  clusterCenter.assign(clusters.size(), sf::Vector2f(0.f, 0.f));
+  std::vector<int> clusterSize(clusters.size(), 0);
+  for (int i = 0; i < int(regions.size()); i++) {
+    regionIndex[regions[i]] = i;
+    auto it = clusterIndex.find(regions[i]->cluster);
+    if (it == clusterIndex.end()) {
+      continue;
+    }
+    regionCluster[i] = it->second;
+    clusterCenter[it->second] += position(regions[i]);
+    clusterSize[it->second]++;
+  }
+  for (int i = 0; i < int(clusters.size()); i++) {
+    if (clusterSize[i] > 0) {
+      clusterCenter[i] /= float(clusterSize[i]);
+    }
+  }
+
+  neighborStart.assign(1, 0);
+  neighbors.clear();
+  for (int i = 0; i < int(regions.size()); i++) {
+    for (auto n : regions[i]->neighbors) {
+      auto it = regionIndex.find(n);
+      if (it != regionIndex.end()) {
+        neighbors.push_back(it->second);
+      }
+    }
+    neighborStart.push_back(int(neighbors.size()));
+  }
+
+  // The portal of a border is the region closest to the middle of all
+  // border regions on this side.
+  std::vector<std::map<int, std::vector<int>>> borders(clusters.size());
+  for (int i = 0; i < int(regions.size()); i++) {
+    int a = regionCluster[i];
+    if (a < 0) {
+      continue;
+    }
+    for (int e = neighborStart[i]; e < neighborStart[i + 1]; e++) {
+      int b = regionCluster[neighbors[e]];
+      if (b >= 0 && b != a) {
+        auto &list = borders[a][b];
+        if (list.empty() || list.back() != i) {
+          list.push_back(i);
+        }
+      }
+    }
+  }
+
+  edgeStart.assign(1, 0);
+  edgeCluster.clear();
+  edgePortal.clear();
+  for (int a = 0; a < int(clusters.size()); a++) {
+    for (auto &pair : borders[a]) {
+      sf::Vector2f middle(0.f, 0.f);
+      for (auto i : pair.second) {
+        middle += position(regions[i]);
+      }
+      middle /= float(pair.second.size());
+      int portal = pair.second[0];
+      for (auto i : pair.second) {
+        if (distance(position(regions[i]), middle) <
+            distance(position(regions[portal]), middle)) {
+          portal = i;
+        }
+      }
+      edgeCluster.push_back(pair.first);
+      edgePortal.push_back(portal);
+    }
+    edgeStart.push_back(int(edgeCluster.size()));
+  }
+  portals = int(edgePortal.size());
+  buildTime = clock.getElapsedTime();
+}
+
+void HierarchicalRouter::clear() {
+  regions.clear();
+  regionIndex.clear();
+  regionCluster.clear();
+  neighborStart.clear();
+  neighbors.clear();
+  clusters.clear();
+  clusterCenter.clear();
+  edgeStart.clear();
+  edgeCluster.clear();
+  edgePortal.clear();
+  portals = 0;
+  routes = 0;
+  fallbacks = 0;
+}
+
+bool HierarchicalRouter::ready() const { return !edgeStart.empty(); }
+
+std::size_t HierarchicalRouter::bytes() const {
+  return (regionCluster.capacity() + neighborStart.capacity() +
+          neighbors.capacity() + edgeStart.capacity() +
+          edgeCluster.capacity() + edgePortal.capacity()) *
+             sizeof(int) +
+         clusterCenter.capacity() * sizeof(sf::Vector2f) +
+         regionIndex.size() * (sizeof(Region *) + sizeof(int) + 16);
+}
+
+// Endpoint clusters are always passable, so sea routes can start on the
+// land cluster of a port.
+bool HierarchicalRouter::clusterPassable(int cluster, CostModel model,
+                                         int from, int to) const {
+  if (cluster == from || cluster == to) {
+    return true;
+  }
+  return model == LAND_ROUTE ? clusters[cluster]->isLand
+                             : !clusters[cluster]->isLand;
+}
+
+// A* over clusters, edge cost is centre -> portal -> neighbour centre.
+// Fills the clusters from start to goal and the portal region leaving
+// each of them but the last.
+bool HierarchicalRouter::corridor(int from, int to, CostModel model,
+                                  std::vector<int> &path,
+                                  std::vector<int> &exits) const {
+  int n = int(clusters.size());
+  std::vector<float> cost(n, -1.f);
+  std::vector<int> parent(n, -1);
+  std::vector<int> parentEdge(n, -1);
+  OpenList open;
+  cost[from] = 0.f;
+  open.push(Entry(distance(clusterCenter[from], clusterCenter[to]), from));
+  while (!open.empty()) {
+    int c = open.top().second;
+    open.pop();
+    if (c == to) {
+      break;
+    }
+    for (int e = edgeStart[c]; e < edgeStart[c + 1]; e++) {
+      int next = edgeCluster[e];
+      if (!clusterPassable(next, model, from, to)) {
+        continue;
+      }
+      auto portal = position(regions[edgePortal[e]]);
+      float g = cost[c] + distance(clusterCenter[c], portal) +
+                distance(portal, clusterCenter[next]);
+      if (cost[next] < 0.f || g < cost[next]) {
+        cost[next] = g;
+        parent[next] = c;
+        parentEdge[next] = e;
+        open.push(Entry(g + distance(clusterCenter[next], clusterCenter[to]),
+                        next));
+      }
+    }
+  }
+
+  path.clear();
+  exits.clear();
+  if (cost[to] < 0.f) {
+    return false;
+  }
+  for (int c = to; c != from; c = parent[c]) {
+    path.push_back(c);
+    exits.push_back(edgePortal[parentEdge[c]]);
+  }
+  path.push_back(from);
+  std::reverse(path.begin(), path.end());
+  std::reverse(exits.begin(), exits.end());
+  return true;
+}
+
+// Region A* limited to the allowed clusters (all clusters if empty).
+std::vector<Region *>
+HierarchicalRouter::refine(int from, int to, CostModel model,
+                           const std::vector<int> &allowed,
+                           Search &search) const {
+  int n = int(regions.size());
+  if (int(search.stamp.size()) != n) {
+    search.cost.assign(n, 0.f);
+    search.parent.assign(n, -1);
+    search.stamp.assign(n, 0);
+    search.closed.assign(n, 0);
+    search.allowed.assign(clusters.size(), 0);
+    search.generation = 0;
+  }
+  unsigned int gen = ++search.generation;
+  for (auto c : allowed) {
+    search.allowed[c] = gen;
+  }
+  bool restricted = !allowed.empty();
+
+  RegionGraph graph(model);
+  graph.heights = heights;
+  auto target = position(regions[to]);
+  OpenList open;
+  search.stamp[from] = gen;
+  search.cost[from] = 0.f;
+  search.parent[from] = -1;
+  open.push(Entry(distance(position(regions[from]), target), from));
+  while (!open.empty()) {
+    int r = open.top().second;
+    open.pop();
+    if (search.closed[r] == gen) {
+      continue;
+    }
+    search.closed[r] = gen;
+    if (r == to) {
+      break;
+    }
+    for (int e = neighborStart[r]; e < neighborStart[r + 1]; e++) {
+      int next = neighbors[e];
+      auto neighbor = regions[next];
+      if (search.closed[next] == gen) {
+        continue;
+      }
+      int c = regionCluster[next];
+      if (restricted && (c < 0 || search.allowed[c] != gen)) {
+        continue;
+      }
+      if (next != to && !graph.passable(neighbor)) {
+        continue;
+      }
+      float g = search.cost[r] + graph.cost(regions[r], neighbor);
+      if (search.stamp[next] != gen || g < search.cost[next]) {
+        search.stamp[next] = gen;
+        search.cost[next] = g;
+        search.parent[next] = r;
+        open.push(Entry(g + distance(position(neighbor), target), next));
+      }
+    }
+  }
+
+  std::vector<Region *> path;
+  if (search.closed[to] != gen) {
+    return path;
+  }
+  for (int r = to; r != -1; r = search.parent[r]) {
+    path.push_back(regions[r]);
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+// The water neighbour of a port closest to the other end of the route,
+// or -1 if the port has no water neighbour.
+int HierarchicalRouter::shore(int port, int toward) const {
+  int best = -1;
+  auto target = position(regions[toward]);
+  for (int e = neighborStart[port]; e < neighborStart[port + 1]; e++) {
+    int n = neighbors[e];
+    if (regions[n]->megaCluster->isLand) {
+      continue;
+    }
+    if (best < 0 || distance(position(regions[n]), target) <
+                        distance(position(regions[best]), target)) {
+      best = n;
+    }
+  }
+  return best;
+}
+
+// The route is refined portal to portal, each leg searching only the
+// clusters around it. If a leg fails (e.g. an impassable strip inside a
+// cluster), the whole corridor is searched, then the corridor widened by
+// one ring of neighbouring clusters, and only then the whole map.
+// Sea routes are planned between the water regions next to the ports and
+// the ports are added back at both ends.
+std::vector<Region *> HierarchicalRouter::route(Region *from, Region *to,
+                                                CostModel model,
+                                                Search &search) const {
+  auto a = regionIndex.find(from);
+  auto b = regionIndex.find(to);
+  if (a == regionIndex.end() || b == regionIndex.end()) {
+    return std::vector<Region *>();
+  }
+  int first = a->second;
+  int last = b->second;
+  if (model == SEA_ROUTE && first != last) {
+    if (from->megaCluster->isLand) {
+      first = shore(a->second, b->second);
+    }
+    if (to->megaCluster->isLand) {
+      last = shore(b->second, a->second);
+    }
+    if (first < 0 || last < 0) {
+      return refine(a->second, b->second, model, {}, search);
+    }
+  }
+  int ca = regionCluster[first];
+  int cb = regionCluster[last];
+  if (ca < 0 || cb < 0) {
+    return refine(a->second, b->second, model, {}, search);
+  }
+  std::vector<int> clustersOnPath;
+  std::vector<int> exits;
+  if (!corridor(ca, cb, model, clustersOnPath, exits)) {
+    return std::vector<Region *>();
+  }
+  routes++;
+
+  std::vector<Region *> path;
+  if (first != a->second) {
+    path.push_back(from);
+  }
+  int k = int(exits.size());
+  int start = first;
+  for (int i = 0; i <= k; i++) {
+    int goal = i < k ? exits[i] : last;
+    std::vector<int> allowed = {clustersOnPath[std::max(0, i - 1)],
+                                clustersOnPath[i],
+                                clustersOnPath[std::min(k, i + 1)]};
+    auto leg = refine(start, goal, model, allowed, search);
+    if (leg.empty()) {
+      path.clear();
+      break;
+    }
+    path.insert(path.end(), leg.begin() + (i == 0 ? 0 : 1), leg.end());
+    start = goal;
+  }
+  if (!path.empty() && last != b->second) {
+    path.push_back(to);
+  }
+
+  if (path.empty()) {
+    fallbacks++;
+    path = refine(a->second, b->second, model, clustersOnPath, search);
+  }
+  if (path.empty()) {
+    auto wide = clustersOnPath;
+    for (auto c : clustersOnPath) {
+      for (int e = edgeStart[c]; e < edgeStart[c + 1]; e++) {
+        wide.push_back(edgeCluster[e]);
+      }
+    }
+    path = refine(a->second, b->second, model, wide, search);
+  }
+  if (path.empty()) {
+    path = refine(a->second, b->second, model, {}, search);
+  }
+  return path;
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include "mapgen/IconAtlas.hpp"
+#include "mapgen/utils.hpp"
+
+IconAtlas::IconAtlas(unsigned int p) : padding(p) {}
+
+void IconAtlas::add(std::string name, const sf::Image &image) {
+  pending[name] = image;
+}
+
+bool IconAtlas::has(std::string name) const {
+  return rects.find(name) != rects.end();
+}
+
+sf::IntRect IconAtlas::getRect(std::string name) const {
+  auto r = rects.find(name);
+  if (r == rects.end()) {
+    return sf::IntRect();
+  }
+  return r->second;
+}
+
+// Simple shelf packing: tallest images first, rows of fixed width.
+// Touches no GL state, so it can run on a loader thread.
+bool IconAtlas::pack(sf::Image &atlas) {
+  if (pending.size() == 0) {
+    return false;
+  }
+
+  std::vector<std::string> names;
+  unsigned int area = 0;
+  unsigned int widest = 0;
+  for (auto &pair : pending) {
+    names.push_back(pair.first);
+    auto size = pair.second.getSize();
+    area += (size.x + padding) * (size.y + padding);
+    widest = std::max(widest, size.x + padding * 2);
+  }
+  std::sort(names.begin(), names.end(), [&](std::string a, std::string b) {
+    return pending[a].getSize().y > pending[b].getSize().y;
+  });
+
+  unsigned int width = 64;
+  while (width * width < area || width < widest) {
+    width *= 2;
+  }
+
+  rects.clear();
+  unsigned int x = padding;
+  unsigned int y = padding;
+  unsigned int shelf = 0;
+  for (auto name : names) {
+    auto size = pending[name].getSize();
+    if (x + size.x + padding > width) {
+      x = padding;
+      y += shelf + padding;
+      shelf = 0;
+    }
+    rects[name] = sf::IntRect(x, y, size.x, size.y);
+    x += size.x + padding;
+    shelf = std::max(shelf, size.y);
+  }
+  unsigned int height = y + shelf + padding;
+
+  atlas.create(width, height, sf::Color::Transparent);
+  for (auto &pair : rects) {
+    atlas.copy(pending[pair.first], pair.second.left, pair.second.top);
+  }
+  pending.clear();
+  return true;
+}
+
+bool IconAtlas::load(const sf::Image &atlas, bool mipmap) {
+  if (!texture.loadFromImage(atlas)) {
+    return false;
+  }
+  texture.setSmooth(true);
+  if (mipmap && !texture.generateMipmap()) {
+    mg::warn("Icon atlas:", "mipmaps are not supported");
+  }
+  mg::info("Icon atlas loaded:", rects.size());
+  return true;
+}
+
+bool IconAtlas::build(bool mipmap) {
+  sf::Image atlas;
+  return pack(atlas) && load(atlas, mipmap);
+}
+
+IconBatch::IconBatch(IconAtlas *a) : atlas(a), vertices(sf::Quads) {}
+
+void IconBatch::add(std::string name, sf::Vector2f position, sf::Color color) {
+  auto rect = atlas->getRect(name);
+  float w = static_cast<float>(rect.width);
+  float h = static_cast<float>(rect.height);
+  float u = static_cast<float>(rect.left);
+  float v = static_cast<float>(rect.top);
+
+  vertices.append(sf::Vertex(position, color, {u, v}));
+  vertices.append(sf::Vertex(position + sf::Vector2f(w, 0), color, {u + w, v}));
+  vertices.append(
+      sf::Vertex(position + sf::Vector2f(w, h), color, {u + w, v + h}));
+  vertices.append(sf::Vertex(position + sf::Vector2f(0, h), color, {u, v + h}));
+}
+
+void IconBatch::clear() { vertices.clear(); }
+
+std::size_t IconBatch::size() const { return vertices.getVertexCount() / 4; }
+
+void IconBatch::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+  if (vertices.getVertexCount() == 0) {
+    return;
+  }
+  states.texture = &atlas->texture;
+  target.draw(vertices, states);
+}
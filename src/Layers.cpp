@@ -21,13 +21,15 @@ void Layer::draw(sf::RenderTarget& target, sf::RenderStates states) const {
     target.draw(sprite, states);
 };
 
-void Layer::update(sf::RenderWindow* window) {
+void Layer::update(sf::RenderWindow* window, const sf::View& view) {
   mg::info("Draw to cache:", name);
   cache->create(window->getSize().x, window->getSize().y, sf::ContextSettings(0, 0, 8));
   cache->clear(sf::Color::Transparent);
+  cache->setView(view);
   for (auto shape : shapes) {
     cache->draw(*shape);
   }
+  cache->setView(cache->getDefaultView());
   if (shader != nullptr) {
     mg::info("Draw shadered", std::string(""));
     sf::RenderTexture temp;
@@ -80,7 +82,7 @@ void Layer::add(sf::Drawable* shape) {
   shapes.push_back(shape);
 }
 
-LayersManager::LayersManager(sf::RenderWindow* w, sf::Shader* m) : window(w), shader_mask(m){};
+LayersManager::LayersManager(sf::RenderWindow* w, sf::Shader* m) : window(w), shader_mask(m), view(w->getDefaultView()){};
 
 void LayersManager::draw(sf::RenderTarget& target, sf::RenderStates states) const {
   for (auto l: layers) {
@@ -112,7 +114,7 @@ void LayersManager::setLayerEnabled(std::string name, bool enabled) {
 
 void LayersManager::invalidateLayer(std::string name) {
   auto l = getLayer(name);
-  l->update(window);
+  l->update(window, view);
 }
 
 void LayersManager::setShader(std::string name, sf::Shader* shader) {
@@ -0,0 +1,154 @@
+#include <iostream>
+
+#include "mapgen/MapHasher.hpp"
+#include "mapgen/Parallel.hpp"
+#include "rang.hpp"
+
+const char *MapHasher::names[MapHasher::STAGES] = {
+    "geometry", "heights", "biomes", "clusters",
+    "rivers",   "roads",   "cities", "weather"};
+
+MapHasher::MapHasher(MapGenerator *m) : mapgen(m) {}
+
+void MapHasher::setMapGenerator(MapGenerator *m) {
+  mapgen = m;
+  clear();
+}
+
+void MapHasher::clear() { stages.clear(); }
+
+bool MapHasher::ready() const { return stages.size() == STAGES; }
+
+// Stages are independent, so each one gets its own thread.
+void MapHasher::hash(const HeightCache *heights, int threads) {
+  sf::Clock clock;
+  std::vector<std::uint64_t> result(STAGES);
+  parallelFor(STAGES,
+              [&](int begin, int end) {
+                for (int s = begin; s < end; s++) {
+                  result[s] = stage(Stage(s), heights);
+                }
+              },
+              threads, 1);
+  stages = result;
+  hashTime = clock.getElapsedTime();
+}
+
+std::uint64_t MapHasher::combined() const {
+  ContentHash h;
+  h.add(stages);
+  return h.value;
+}
+
+// Site heights come from the cache when it is built for this map, otherwise
+// they are sampled from libmapgen; both give the same hash.
+std::uint64_t MapHasher::stage(Stage s, const HeightCache *heights) const {
+  ContentHash h;
+  auto map = mapgen->map;
+  auto &regions = map->regions;
+  switch (s) {
+  case GEOMETRY:
+    h.add(regions.size());
+    for (auto r : regions) {
+      h.add(r->site);
+      for (auto p : r->getPoints()) {
+        h.add(p);
+      }
+    }
+    break;
+  case HEIGHTS:
+    if (heights != nullptr && heights->ready() &&
+        heights->siteHeight.size() == regions.size()) {
+      h.add(heights->siteHeight);
+    } else {
+      std::vector<float> sites;
+      sites.reserve(regions.size());
+      for (auto r : regions) {
+        sites.push_back(r->getHeight(r->site));
+      }
+      h.add(sites);
+    }
+    break;
+  case BIOMES:
+    for (auto r : regions) {
+      h.add(r->biom.name);
+      h.add(r->minerals);
+    }
+    break;
+  case CLUSTERS:
+    h.add(map->clusters.size());
+    for (auto c : map->clusters) {
+      h.add(c->isLand);
+      h.add(c->regions.size());
+      for (auto r : c->regions) {
+        h.add(r->site);
+      }
+    }
+    break;
+  case RIVERS:
+    h.add(map->rivers.size());
+    for (auto river : map->rivers) {
+      h.add(river->points->size());
+      for (auto p : *river->points) {
+        h.add(p);
+      }
+    }
+    break;
+  case ROADS:
+    h.add(map->roads.size());
+    for (auto road : map->roads) {
+      h.add(road->seaPath);
+      h.add(road->regions.size());
+      for (auto r : road->regions) {
+        h.add(r->site);
+      }
+    }
+    break;
+  case CITIES:
+    h.add(map->cities.size());
+    for (auto c : map->cities) {
+      h.add(c->name);
+      h.add(c->type);
+      h.add(c->region->site);
+      h.add(c->population);
+      h.add(c->wealth);
+    }
+    break;
+  case WEATHER:
+    h.add(mapgen->weather->windAngle);
+    h.add(mapgen->weather->windForce);
+    for (auto r : regions) {
+      h.add(r->humidity);
+      h.add(r->temperature);
+    }
+    break;
+  default:
+    break;
+  }
+  return h.value;
+}
+
+// Prints the time per stage next to the last generation, to keep hashing
+// cheap compared to generation itself.
+// Times the full hash on a scratch hasher, so the shown stage hashes are
+// not rewritten while the UI reads them.
+void MapHasher::benchmark(const HeightCache *heights, int runs) const {
+  std::cout << "map hash, " << mapgen->map->regions.size() << " regions\n";
+  for (int s = 0; s < STAGES; s++) {
+    sf::Clock clock;
+    for (int i = 0; i < runs; i++) {
+      stage(Stage(s), heights);
+    }
+    std::cout << "  " << names[s] << ": " << rang::fg::green
+              << clock.getElapsedTime().asMicroseconds() / 1000.f / runs
+              << "ms" << rang::style::reset << '\n';
+  }
+  MapHasher scratch(mapgen);
+  sf::Clock clock;
+  for (int i = 0; i < runs; i++) {
+    scratch.hash(heights);
+  }
+  std::cout << "  all stages, parallel: " << rang::fg::green
+            << clock.getElapsedTime().asMicroseconds() / 1000.f / runs << "ms"
+            << rang::style::reset << '\n';
+}
@@ -22,28 +22,6 @@
 #include "mapgen/hslColor.hpp"
 #include "rang.hpp"
 
-#include <experimental/filesystem>
-namespace fs = std::experimental::filesystem;
-
-  // TODO: rewrite this horror
-  std::string get_selfpath() {
-    int bl;
-#ifdef _WIN32
-    char buff[MAX_PATH];
-    GetModuleFileName(NULL, buff, sizeof(buff));
-#else
-    char buff[PATH_MAX];
-    ssize_t len = ::readlink("/proc/self/exe", buff, sizeof(buff) - 1);
-    if (len != -1) {
-      buff[len] = '\0';
-    }
-#endif
-    auto path = fs::path(buff);
-    std::cout << path << std::endl;
-    return path.parent_path().string();
-  }
-
-
 std::map<Biom, sf::Color> biomColors = {
     {biom::ABYSS, sf::Color(23, 23, 40)},
     {biom::DEEP, sf::Color(39, 39, 70)},
@@ -74,12 +52,6 @@ std::map<std::string, sf::Color> stateColors = {
 std::map<Road*, sw::Spline*> splines = {};
 
 
-inline bool ends_with(std::string const &value, std::string const &ending) {
-  if (ending.size() > value.size())
-    return false;
-  return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
-}
-
 // TODO: move ints to utils.cpp
 template <typename T> using filterFunc = std::function<bool(T *)>;
 template <typename T> using sortFunc = std::function<bool(T *, T *)>;
@@ -96,39 +68,36 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
 }
 
   // TODO: use map instead mapgen
-  Painter::Painter(sf::RenderWindow *w, MapGenerator *m, std::string v)
-      : window(w), mapgen(m), VERSION(v) {
-
-    auto dir = get_selfpath();
-    char path[100];
-    sprintf(path, "%s/font.ttf", dir.c_str());
-    // mg::info("Loading font:", path.string());
-    sffont.loadFromFile(sf::String(path));
+  Painter::Painter(sf::RenderWindow *w, MapGenerator *m, AssetManager *a,
+                   std::string v)
+      : window(w), mapgen(m), assets(a), VERSION(v), walkers(m) {
+
+    assets->wait();
+    sffont = assets->font;
     loadImages();
     initProgressBar();
 
     sf::Vector2u windowSize = window->getSize();
     cachedMap.create(windowSize.x, windowSize.y);
+    cachedSprite.setTexture(cachedMap.getTexture(), true);
 
     bgColor = sf::Color(23, 23, 23);
     window->clear(bgColor);
 
-    char spath[100];
-    sprintf(spath, "%s/blur.frag", dir.c_str());
-
-    if(shader_blur.loadFromFile(spath, sf::Shader::Type::Fragment)) {
+    auto blur = assets->shaders["blur"];
+    if(shader_blur.loadFromMemory(blur, sf::Shader::Type::Fragment)) {
       fmt::print("Blur shader loaded\n");
     }
     shader_blur.setUniform("blur_radius", 0.004f);
-    shader_lesser_blur.loadFromFile(spath, sf::Shader::Type::Fragment);
+    shader_lesser_blur.loadFromMemory(blur, sf::Shader::Type::Fragment);
     shader_lesser_blur.setUniform("blur_radius", 0.002f);
     // shader_blur.setParameter("blur_radius", 0.004f);
-    sprintf(spath, "%s/mask.frag", dir.c_str());
-    if(shader_mask.loadFromFile(spath, sf::Shader::Type::Fragment)) {
+    if(shader_mask.loadFromMemory(assets->shaders["mask"], sf::Shader::Type::Fragment)) {
       fmt::print("Mask shader loaded\n ");
     }
 
     layers = new LayersManager(window, &shader_mask);
+    camera = window->getDefaultView();
   };
 
   void Painter::initProgressBar() {
@@ -139,34 +108,32 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
   }
 
   void Painter::loadImages() {
-    std::map<LocationType, std::string> iconMap = {
+    locationIcons = {
         {CAPITAL, "castle"}, {PORT, "docks"},  {MINE, "mine"},
         {AGRO, "farm"},      {TRADE, "trade"}, {LIGHTHOUSE, "lighthouse"},
         {CAVE, "cave"},      {FORT, "fort"}};
 
-    auto dir = get_selfpath();
-    char path[100];
-
-    sprintf(path, "%s/images", dir.c_str());
-    for (auto &d : fs::directory_iterator(path)) {
-      fs::path path = d.path();
-      if (!ends_with(path.string(), ".png")) {
-        continue;
-      }
+    for (auto &pair : assets->images) {
       sf::Texture *icon = new sf::Texture();
-      mg::info("Loading image:", path);
-      icon->loadFromFile(path.string());
+      icon->loadFromImage(pair.second);
       icon->setSmooth(true);
-      images[path.stem().string()] = icon;
+      images[pair.first] = icon;
     }
 
-    for (auto pair : iconMap) {
-      locationIcons.insert(std::make_pair(pair.first, images[pair.second]));
-    }
+    iconAtlas = &assets->atlas;
+    iconAtlas->load(assets->atlasImage, mipmapIcons);
+    locationBatch = new IconBatch(iconAtlas);
+  }
+
+  // Re-uploads the atlas texture after mipmapIcons changed.
+  void Painter::reloadIcons() {
+    iconAtlas->load(assets->atlasImage, mipmapIcons);
+    invalidate(true);
   }
 
   void Painter::invalidate(bool force) {
     needUpdate = true;
+    cameraOnly = false;
     if (force) {
       for (auto l : layers->layers) {
         l->damaged = true;
@@ -174,6 +141,22 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
     }
   }
 
+  // Weather only affects the overlays and land colours, so other layers
+  // keep their rasterized caches.
+  void Painter::invalidateWeather() {
+    needUpdate = true;
+    cameraOnly = false;
+    for (auto name : {"hum", "temp", "land", "wind"}) {
+      layers->getLayer(name)->damaged = true;
+    }
+  }
+
+  bool Painter::isDirty() { return needUpdate; }
+
+  bool Painter::isAnimating() {
+    return (showWalkers && walkers.size() != 0) || (wind && windParticles);
+  }
+
   void Painter::fade() {
     sf::RectangleShape rectangle;
     rectangle.setSize(sf::Vector2f(window->getSize().x, window->getSize().y));
@@ -225,64 +208,69 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
   }
 
 
+  void Painter::updateHighlight(Region *currentRegion) {
+    infoPolygons.clear();
+    // if (currentRegion->city != nullptr && !roads) {
+    //   for (auto r : currentRegion->city->roads) {
+    //     drawRoad(r);
+    //   }
+    // }
+    PointList points = currentRegion->getPoints();
+    Cluster *cluster = currentRegion->cluster;
+
+    int i = 0;
+    for (std::vector<Region *>::iterator
+             it = cluster->megaCluster->regions.begin();
+         it < cluster->megaCluster->regions.end(); it++, i++) {
+
+      Region *region = cluster->megaCluster->regions[i];
+      sf::ConvexShape polygon;
+      PointList points = region->getPoints();
+      polygon.setPointCount(points.size());
+      int n = 0;
+      for (PointList::iterator it2 = points.begin(); it2 < points.end();
+           it2++, n++) {
+        sf::Vector2<double> *p = points[n];
+        polygon.setPoint(n, sf::Vector2f(p->x, p->y));
+      }
+      sf::Color col = sf::Color::Black;
+      col.a = 20;
+      polygon.setFillColor(col);
+      polygon.setOutlineColor(col);
+      polygon.setOutlineThickness(1);
+      infoPolygons.push_back(polygon);
+    }
+    i = 0;
+    for (std::vector<Region *>::iterator it = cluster->regions.begin();
+         it < cluster->regions.end(); it++, i++) {
+
+      Region *region = cluster->regions[i];
+      sf::ConvexShape polygon;
+      PointList points = region->getPoints();
+      polygon.setPointCount(points.size());
+      int n = 0;
+      for (PointList::iterator it2 = points.begin(); it2 < points.end();
+           it2++, n++) {
+        sf::Vector2<double> *p = points[n];
+        polygon.setPoint(n, sf::Vector2f(p->x, p->y));
+      }
+      sf::Color col = sf::Color::Red;
+      col.a = 50;
+      polygon.setFillColor(col);
+      polygon.setOutlineColor(col);
+      polygon.setOutlineThickness(1);
+      infoPolygons.push_back(polygon);
+    }
+  }
+
   void Painter::drawInfo(Region *currentRegion) {
     sf::ConvexShape selectedPolygon;
 
     if (currentRegion != currentRegionCache) {
       currentRegionCache = currentRegion;
-
-      infoPolygons.clear();
-      // if (currentRegion->city != nullptr && !roads) {
-      //   for (auto r : currentRegion->city->roads) {
-      //     drawRoad(r);
-      //   }
-      // }
-      PointList points = currentRegion->getPoints();
-      Cluster *cluster = currentRegion->cluster;
-
-      int i = 0;
-      for (std::vector<Region *>::iterator
-               it = cluster->megaCluster->regions.begin();
-           it < cluster->megaCluster->regions.end(); it++, i++) {
-
-        Region *region = cluster->megaCluster->regions[i];
-        sf::ConvexShape polygon;
-        PointList points = region->getPoints();
-        polygon.setPointCount(points.size());
-        int n = 0;
-        for (PointList::iterator it2 = points.begin(); it2 < points.end();
-             it2++, n++) {
-          sf::Vector2<double> *p = points[n];
-          polygon.setPoint(n, sf::Vector2f(p->x, p->y));
-        }
-        sf::Color col = sf::Color::Black;
-        col.a = 20;
-        polygon.setFillColor(col);
-        polygon.setOutlineColor(col);
-        polygon.setOutlineThickness(1);
-        infoPolygons.push_back(polygon);
-      }
-      i = 0;
-      for (std::vector<Region *>::iterator it = cluster->regions.begin();
-           it < cluster->regions.end(); it++, i++) {
-
-        Region *region = cluster->regions[i];
-        sf::ConvexShape polygon;
-        PointList points = region->getPoints();
-        polygon.setPointCount(points.size());
-        int n = 0;
-        for (PointList::iterator it2 = points.begin(); it2 < points.end();
-             it2++, n++) {
-          sf::Vector2<double> *p = points[n];
-          polygon.setPoint(n, sf::Vector2f(p->x, p->y));
-        }
-        sf::Color col = sf::Color::Red;
-        col.a = 50;
-        polygon.setFillColor(col);
-        polygon.setOutlineColor(col);
-        polygon.setOutlineThickness(1);
-        infoPolygons.push_back(polygon);
-      }
+      defer("highlight", [this, currentRegion]() {
+        updateHighlight(currentRegion);
+      });
     }
     sf::CircleShape site(2.f);
 
@@ -410,17 +398,16 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
   }
 
   void Painter::drawMap() {
-    if (needUpdate) {
+    if (needUpdate && !frozen) {
       auto t0 = std::chrono::system_clock::now();
 
-      cachedMap.clear(sf::Color::Transparent);
-
       std::vector<std::string> order = {
         "water", "waterClear",
         "landBorder", "land",
         "roads", "rivers",
         "forrest",
         "lakes",
+        "relief",
 
         "heights",
         "temp",
@@ -501,6 +488,16 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
         drawHeights();
       }
 
+      l = layers->getLayer("relief");
+      if (l->enabled != relief || l->damaged) {
+        l->enabled = relief;
+        l->damaged = true;
+        l->clear();
+        if (l->enabled) {
+          drawRelief();
+        }
+      }
+
       l = layers->getLayer("temp");
       if (l->enabled != temp || l->damaged) {
         l->enabled = temp;
@@ -509,6 +506,16 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
         drawTemp();
       }
 
+      l = layers->getLayer("wind");
+      if (l->enabled != wind || l->damaged) {
+        l->enabled = wind;
+        l->damaged = true;
+        l->clear();
+        if (l->enabled) {
+          drawWind();
+        }
+      }
+
       l = layers->getLayer("hum");
       if (l->enabled != hum || l->damaged) {
         l->enabled = hum;
@@ -527,20 +534,18 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
       layers->setShader("water", &shader_blur);
       layers->setMask("rivers", layers->getLayer("land"));
 
+      // Rasterization is spread across frames, the previous cachedMap stays
+      // on screen until all damaged layers are redrawn.
       for (auto name : order) {
         if (layers->getLayer(name)->damaged) {
-          layers->invalidateLayer(name);
+          defer("layer:" + name, [this, name]() {
+            layers->invalidateLayer(name);
+          });
         }
       }
+      defer("composeMap", [this]() { composeMap(); });
 
       needUpdate = false;
-      if (useCacheMap) {
-        cachedMap.draw(*layers);
-      }
-
-      if (wind) {
-        drawWind();
-      }
       drawMap();
 
       auto t1 = std::chrono::system_clock::now();
@@ -549,20 +554,29 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
         std::cout << "time taken by drawMap[needUpdate]: " << rang::fg::green << ms.count() << rang::style::reset << '\n';
     } else {
       if (useCacheMap) {
-        sf::RectangleShape rectangle;
-        rectangle.setSize(sf::Vector2f(window->getSize().x,
-        window->getSize().y));
-        rectangle.setPosition(0, 0);
-        cachedMap.display();
-        rectangle.setTexture(&(cachedMap.getTexture()));
-
-        window->draw(rectangle);
+        window->draw(cachedSprite);
       } else {
       window->draw(*layers);
       }
     }
   }
 
+  void Painter::composeMap() {
+    cachedMap.clear(sf::Color::Transparent);
+    if (useCacheMap) {
+      cachedMap.draw(*layers);
+    }
+    cachedMap.display();
+  }
+
+  void Painter::defer(std::string name, std::function<void()> task) {
+    if (scheduler == nullptr) {
+      task();
+      return;
+    }
+    scheduler->defer(name, task);
+  }
+
   void Painter::drawBorders() {
     auto layer = layers->getLayer("borders");
     auto ends = filterObjects(
@@ -660,37 +674,30 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
     layers->getLayer("watermark")->add(mark);
   }
 
-  void Painter::drawObjects(std::vector<sf::ConvexShape> op) {
+  void Painter::drawObjects(std::vector<sf::ConvexShape *> &op) {
     for (auto obj : op) {
-      window->draw(obj);
+      window->draw(*obj);
     }
   }
 
   void Painter::drawLocations() {
+    locationBatch->clear();
     for (Region *region : mapgen->map->regions) {
-      if (region->location != nullptr) {
-        auto sprite = new sf::Sprite();
-
-        if ((region->city != nullptr) || (region->city == nullptr)) {
-          // auto texture = images["village"];
-          auto texture = locationIcons[region->location->type];
-          if (region->city != nullptr) {
-            if (region->city->isCapital) {
-              texture = locationIcons[CAPITAL];
-            } else if (region->city->population > 2000) {
-              // texture = icons["castle"];
-            }
-          }
-          sprite->setTexture(*texture);
-          auto p = region->site;
-          // auto size = texture->getSize();
-          // sprite.setScale(0.05, 0.05);
-          sprite->setPosition(
-              sf::Vector2f(p->x - iconSize / 2.f, p->y - iconSize / 2.f));
-          layers->getLayer("locations")->add(sprite);
-        }
+      if (region->location == nullptr) {
+        continue;
       }
+      auto icon = locationIcons[region->location->type];
+      if (region->city != nullptr && region->city->isCapital) {
+        icon = locationIcons[CAPITAL];
+      }
+      if (!iconAtlas->has(icon)) {
+        continue;
+      }
+      auto p = region->site;
+      locationBatch->add(icon, sf::Vector2f(p->x - iconSize / 2.f,
+                                            p->y - iconSize / 2.f));
     }
+    layers->getLayer("locations")->add(locationBatch);
   }
 
   void Painter::drawLakes() {
@@ -708,6 +715,20 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
     }
   }
 
+  void Painter::drawRelief() {
+    if (!heightRaster.ready()) {
+      return;
+    }
+    sf::Image image;
+    heightRaster.shade(image);
+    reliefTexture.loadFromImage(image);
+    reliefTexture.setSmooth(true);
+    reliefSprite.setTexture(reliefTexture, true);
+    reliefSprite.setScale(heightRaster.mapWidth / (heightRaster.width - 1),
+                          heightRaster.mapHeight / (heightRaster.height - 1));
+    layers->getLayer("relief")->add(&reliefSprite);
+  }
+
   void Painter::drawHeights() {
     for (auto region : mapgen->map->regions) {
       if (!region->cluster->isLand) continue;
@@ -723,7 +744,7 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
       }
 
       auto col = sf::Color::Black;
-      col.r = 255 * (region->getHeight(region->site)) / 1.6;
+      col.r = 255 * heightCache.site(region) / 1.6;
       col.b = 20;
       col.g = 20;
       polygon->setFillColor(col);
@@ -798,36 +819,7 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
       polygon->setPoint(n, sf::Vector2f(p->x, p->y));
     }
 
-      sf::Color col(biomColors[region->biom]);
-
-    if (region->border && !region->megaCluster->isLand) {
-      int r = col.r;
-      int g = col.g;
-      int b = col.b;
-      int s = 1;
-      for (auto n : region->neighbors) {
-        if (n->megaCluster->isLand) {
-          continue;
-        }
-          r += biomColors[n->biom].r;
-          g += biomColors[n->biom].g;
-          b += biomColors[n->biom].b;
-        s++;
-      }
-      col.r = r / s;
-      col.g = g / s;
-      col.b = b / s;
-    }
-    auto hsl = TurnToHSL(col);
-    if (region->megaCluster->isLand) {
-      float h = region->getHeight(region->site);
-      hsl.Luminance -= 20;
-      hsl.Luminance += lumDelta * h;
-      hsl.Luminance = std::max(hsl.Luminance, double(0));
-      hsl.Luminance = std::min(hsl.Luminance, double(100));
-    }
-    hsl.Hue += (rand() % (hueDelta*2)) - hueDelta;
-    col = hsl.TurnToRGB();
+    auto col = getColor(region);
 
     if (useTextures) {
       if (region->biom == biom::FORREST ||
@@ -869,43 +861,145 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
       polygon->setOutlineThickness(1);
     }
 
+    return polygon;
+  }
+
+  sf::Color Painter::getColor(Region *region) {
+    sf::Color col(biomColors[region->biom]);
+
+    if (region->border && !region->megaCluster->isLand) {
+      int r = col.r;
+      int g = col.g;
+      int b = col.b;
+      int s = 1;
+      for (auto n : region->neighbors) {
+        if (n->megaCluster->isLand) {
+          continue;
+        }
+          r += biomColors[n->biom].r;
+          g += biomColors[n->biom].g;
+          b += biomColors[n->biom].b;
+        s++;
+      }
+      col.r = r / s;
+      col.g = g / s;
+      col.b = b / s;
+    }
+    auto hsl = TurnToHSL(col);
+    if (region->megaCluster->isLand) {
+      float h = heightCache.site(region);
+      hsl.Luminance -= 20;
+      hsl.Luminance += lumDelta * h;
+      hsl.Luminance = std::max(hsl.Luminance, double(0));
+      hsl.Luminance = std::min(hsl.Luminance, double(100));
+    }
+    int index = std::max(0, store.indexOf(region));
+    hsl.Hue += RandomStream(mapgen->getSeed(), "hue").below(index, 0, hueDelta * 2) -
+               hueDelta;
+    col = hsl.TurnToRGB();
+
     if (minerals && (region->megaCluster->isLand || !blur)) {
-        sf::Color col(biomColors[region->biom]);
+      col = biomColors[region->biom];
       col.g = 255 * (region->minerals) / 1.2;
       col.b = col.b / 3;
       col.r = col.g / 3;
-      polygon->setFillColor(col);
     }
+    return col;
+  }
 
-    return polygon;
+  // The downwind table is built once per (map, wind) and shared with the
+  // weather recomputation, which hands over the table for the new wind.
+  std::shared_ptr<WindField> Painter::getWindField() {
+    auto &regions = mapgen->map->regions;
+    auto weather = mapgen->weather;
+    if (windField == nullptr ||
+        !windField->matches(regions, weather->windAngle, weather->windForce)) {
+      auto field = std::make_shared<WindField>();
+      field->build(regions, weather->windAngle, weather->windForce);
+      mg::info("Wind field built [ms]:", field->buildTime.asMilliseconds());
+      windField = field;
+    }
+    return windField;
   }
 
-  void Painter::drawWind() {
+  void Painter::setWindField(std::shared_ptr<WindField> field) {
+    windField = field;
+  }
 
-    std::vector<Region *> regions = mapgen->map->regions;
-    for (Region *region : regions) {
-      if (!region->cluster->isLand) continue;
-        sf::Vertex line[2];
+  void Painter::dropWindField() {
+    windField = nullptr;
+    particles.clear();
+  }
+
+  // Everything derived from the old map is rebuilt by the caller.
+  void Painter::setMapGenerator(MapGenerator *m) {
+    mapgen = m;
+    walkers.setMapGenerator(m);
+    dropWindField();
+    invalidate(true);
+  }
 
-      line[0].position = sf::Vector2f(static_cast<float>(region->site->x),
-                                      static_cast<float>(region->site->y));
-      line[0].color = sf::Color::Green;
-      auto r2 = region->getRegionWithDirection(mapgen->weather->windAngle, mapgen->weather->windForce);
-      if (r2 == nullptr) continue;
-      line[1].position =
-          sf::Vector2f(static_cast<float>(r2->site->x),
-                       static_cast<float>(r2->site->y));
-      line[1].color = sf::Color::Red;
+  // All wind lines (and arrow heads) go into one vertex array owned by the
+  // "wind" layer, so the overlay costs a single draw call when rasterized.
+  void Painter::drawWind() {
+    auto &regions = mapgen->map->regions;
+    auto field = getWindField();
 
-        cachedMap.draw(line, 2, sf::Lines);
+    windLines.setPrimitiveType(sf::Lines);
+    windLines.clear();
+    for (int i = 0; i < int(regions.size()); i++) {
+      Region *region = regions[i];
+      if (!region->cluster->isLand) continue;
+      int d = field->downwind[i];
+      if (d < 0) continue;
+
+      sf::Vector2f from(static_cast<float>(region->site->x),
+                        static_cast<float>(region->site->y));
+      sf::Vector2f to(static_cast<float>(regions[d]->site->x),
+                      static_cast<float>(regions[d]->site->y));
+      windLines.append(sf::Vertex(from, sf::Color::Green));
+      windLines.append(sf::Vertex(to, sf::Color::Red));
+
+      if (windArrows) {
+        auto dir = from - to;
+        float length = std::sqrt(dir.x * dir.x + dir.y * dir.y);
+        if (length < 1.f) continue;
+        dir = dir * (4.f / length);
+        const float c = 0.906f; // cos(25deg)
+        const float s = 0.423f; // sin(25deg)
+        sf::Vector2f left(dir.x * c - dir.y * s, dir.x * s + dir.y * c);
+        sf::Vector2f right(dir.x * c + dir.y * s, -dir.x * s + dir.y * c);
+        windLines.append(sf::Vertex(to, sf::Color::Red));
+        windLines.append(sf::Vertex(to + left, sf::Color::Red));
+        windLines.append(sf::Vertex(to, sf::Color::Red));
+        windLines.append(sf::Vertex(to + right, sf::Color::Red));
       }
     }
+    layers->getLayer("wind")->add(&windLines);
+  }
+
+  void Painter::drawWindParticles() {
+    auto field = getWindField();
+    if (!particles.uses(field)) {
+      particles.init(field, mapgen->map->regions, windParticlesCount,
+                     mapgen->getSeed());
+      particlesClock.restart();
+    }
+    particles.tick(std::min(particlesClock.restart().asSeconds(), 0.1f));
+    window->draw(particles);
+  }
 
   void Painter::drawPolygons() {
     infoPolygons.clear();
     poi.clear();
     walkers.clear();
     currentRegionCache = nullptr;
+    needUpdate = true;
+
+    if (largeMap) {
+      drawPolygonTiles();
+      return;
+    }
 
     std::vector<Region *> regions = mapgen->map->regions;
     for (Region *region : regions) {
@@ -932,8 +1026,109 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
         layers->getLayer("waterClear")->add(polygon);
       }
     }
+  }
 
-    needUpdate = true;
+  // Large map mode: the same land/border/water split as drawPolygons, but
+  // as three tiled triangle meshes instead of a shape per region. Only one
+  // of "water" (blurred, with coasts) and "waterClear" is enabled, so they
+  // share the water mesh.
+  void Painter::drawPolygonTiles() {
+    auto &regions = mapgen->map->regions;
+    if (store.size() != regions.size()) {
+      store.build(regions, mapgen->map->clusters);
+      cameraOnly = false;
+    }
+    if (cameraOnly && landMesh.tileCount() != 0) {
+      cameraOnly = false;
+      streamTiles();
+      return;
+    }
+    int n = int(regions.size());
+    std::vector<sf::Color> colors(n);
+    std::vector<sf::Color> borderColors(n);
+    std::vector<char> land(n, 0);
+    std::vector<char> water(n, 0);
+    for (int i = 0; i < n; i++) {
+      auto region = regions[i];
+      if (region->biom == biom::LAKE) {
+        continue;
+      }
+      colors[i] = getColor(region);
+      if (region->megaCluster->isLand) {
+        land[i] = 1;
+        water[i] = blur && region->isCoast();
+        auto hsl = TurnToHSL(biomColors[region->biom]);
+        hsl.Luminance -= 20;
+        borderColors[i] = hsl.TurnToRGB();
+        borderColors[i].a = 180;
+      } else {
+        water[i] = 1;
+      }
+    }
+
+    auto size = sf::Vector2f(window->getSize());
+    landMesh.build(store, colors, land, sf::Vector2f(0, 0), size.x, size.y);
+    landBorderMesh.build(store, borderColors, land,
+                         sf::Vector2f(0, landBorderHeight), size.x, size.y);
+    waterMesh.build(store, colors, water, sf::Vector2f(0, 0), size.x, size.y);
+    streamTiles();
+  }
+
+  // Builds the tiles the camera sees and hands the meshes to their layers.
+  // A redraw caused only by a camera move streams tiles into the existing
+  // meshes instead of rebuilding them.
+  void Painter::streamTiles() {
+    sf::FloatRect visible(camera.getCenter() - camera.getSize() / 2.f,
+                          camera.getSize());
+    landMesh.stream(visible);
+    landBorderMesh.stream(visible);
+    waterMesh.stream(visible);
+    layers->getLayer("land")->add(&landMesh);
+    layers->getLayer("landBorder")->add(&landBorderMesh);
+    layers->getLayer("water")->add(&waterMesh);
+    layers->getLayer("waterClear")->add(&waterMesh);
+  }
+
+  void Painter::setCamera(const sf::View &view) {
+    camera = view;
+    layers->view = view;
+    bool moved = !needUpdate || cameraOnly;
+    invalidate(true);
+    cameraOnly = moved;
+  }
+
+  void Painter::resetCamera() { setCamera(window->getDefaultView()); }
+
+  // The three meshes share the budget equally.
+  void Painter::setMeshBudget(std::size_t bytes) {
+    landMesh.budget = bytes / 3;
+    landBorderMesh.budget = bytes / 3;
+    waterMesh.budget = bytes / 3;
+  }
+
+  std::size_t Painter::meshBytes() const {
+    return landMesh.bytes() + landBorderMesh.bytes() + waterMesh.bytes();
+  }
+
+  // Approximate bytes held by each viewer stage; layer caches are counted
+  // as one RGBA window-sized texture each.
+  std::vector<std::pair<std::string, std::size_t>> Painter::memoryReport() {
+    auto size = window->getSize();
+    std::size_t screen = std::size_t(size.x) * size.y * 4;
+    int cached = 1;
+    for (auto l : layers->layers) {
+      if (l->cache != nullptr) {
+        cached++;
+      }
+    }
+    return {
+        {"region store", store.bytes()},
+        {"tile meshes", meshBytes()},
+        {"height cache", heightCache.bytes()},
+        {"height raster", heightRaster.bytes()},
+        {"wind field", windField != nullptr ? windField->bytes() : 0},
+        {"layer textures", screen * cached},
+    };
   }
 
   sf::Texture Painter::getScreenshot() {
@@ -944,9 +1139,16 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
     return texture;
   }
 
+  // Leaves the camera set on the window, so overlays drawn after this are
+  // in map coordinates.
   void Painter::draw() {
     window->clear(bgColor);
     drawMap();
+    window->setView(camera);
+
+    if (wind && windParticles) {
+      drawWindParticles();
+    }
 
     if (showWalkers) {
       if (mapgen->map->roads.size() != 0) {
@@ -956,24 +1158,12 @@ std::vector<T *> filterObjects(std::vector<T *> regions, filterFunc<T> filter,
   }
 
   void Painter::drawWalkers() {
-    if (walkers.size() == 0) {
-      int n = 0;
-      while (n < mapgen->map->cities.size()) {
-        auto c = mapgen->map->cities[n];
-        if (c->roads.size() == 0) {
-          n++;
-          continue;
-        }
-        auto w = new Walker(c, mapgen);
-        walkers.push_back(w);
-        n++;
-      }
-    } else {
-      for (auto w : walkers) {
-        w->tick();
-        if (w->shape != nullptr) {
-          window->draw(*w->shape);
-        }
-      }
+    if (!walkers.initialized) {
+      walkers.init(mapgen->getSeed(), walkersCount, splines);
+      walkersClock.restart();
     }
+    walkers.tick(std::min(walkersClock.restart().asSeconds(), 0.1f));
+    window->draw(walkers);
   }
+
+  void Painter::resetWalkers() { walkers.clear(); }
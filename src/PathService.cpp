@@ -0,0 +1,165 @@
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "mapgen/PathService.hpp"
+#include "mapgen/MapGenerator.hpp"
+#include "mapgen/utils.hpp"
+
+PathService::Worker::Worker(CostModel model, const HeightCache *heights)
+    : graph(model), pather(&graph, 1024, 6, true) {
+  graph.heights = heights;
+}
+
+PathService::PathService() {}
+
+PathService::~PathService() { clear(); }
+
+PathService::Worker *PathService::worker(int thread, CostModel model) {
+  auto &slot = workers[thread][model];
+  if (!slot) {
+    slot.reset(new Worker(model, hierarchy.heights));
+  }
+  return slot.get();
+}
+
+// Claims the query when nobody has solved it yet; otherwise waits for the
+// thread that is solving it and returns its path.
+bool PathService::cached(PathQuery &query, std::vector<Region *> &path) {
+  std::unique_lock<std::mutex> lock(mutex);
+  queries++;
+  auto key = std::make_tuple(query.from, query.to, int(query.model));
+  solved.wait(lock, [&]() { return solving.count(key) == 0; });
+  auto it = memo.find(key);
+  if (it == memo.end()) {
+    solving.insert(key);
+    return false;
+  }
+  hits++;
+  path = it->second;
+  return true;
+}
+
+std::vector<Region *> PathService::solve(Worker *w, PathQuery &query) {
+  std::vector<Region *> path;
+  if (cached(query, path)) {
+    return path;
+  }
+
+  if (hierarchical && hierarchy.ready() &&
+      query.from->cluster != query.to->cluster) {
+    path = hierarchy.route(query.from, query.to, query.model, w->search);
+  } else {
+    MP_VECTOR<void *> states;
+    float total = 0.f;
+    w->pather.Solve(query.from, query.to, &states, &total);
+    for (auto s : states) {
+      path.push_back(static_cast<Region *>(s));
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (path.empty() && query.from != query.to) {
+      unreachable++;
+    }
+    auto key = std::make_tuple(query.from, query.to, int(query.model));
+    memo[key] = path;
+    solving.erase(key);
+  }
+  solved.notify_all();
+  return path;
+}
+
+std::vector<Region *> PathService::route(Region *from, Region *to,
+                                         CostModel model) {
+  std::vector<PathQuery> queries = {PathQuery{from, to, model}};
+  return routeAll(queries, 1)[0];
+}
+
+std::vector<std::vector<Region *>>
+PathService::routeAll(std::vector<PathQuery> &batch, int threads) {
+  sf::Clock clock;
+  if (threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::max(1, std::min(threads, int(batch.size())));
+  while (int(workers.size()) < threads) {
+    workers.push_back(std::vector<std::unique_ptr<Worker>>(2));
+  }
+
+  std::vector<std::vector<Region *>> paths(batch.size());
+  std::atomic<int> next(0);
+  auto run = [&](int t) {
+    for (int i = next++; i < int(batch.size()); i = next++) {
+      paths[i] = solve(worker(t, batch[i].model), batch[i]);
+    }
+  };
+  if (threads == 1) {
+    run(0);
+  } else {
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+      pool.push_back(std::thread(run, t));
+    }
+    for (auto &t : pool) {
+      t.join();
+    }
+  }
+  routingTime += clock.getElapsedTime();
+  return paths;
+}
+
+// Every unordered pair once; sea routes only between ports.
+std::vector<PathQuery> PathService::cityPairs(std::vector<City *> &cities,
+                                              CostModel model) {
+  std::vector<PathQuery> result;
+  for (int i = 0; i < int(cities.size()); i++) {
+    if (model == SEA_ROUTE && cities[i]->type != PORT) {
+      continue;
+    }
+    for (int j = i + 1; j < int(cities.size()); j++) {
+      if (model == SEA_ROUTE && cities[j]->type != PORT) {
+        continue;
+      }
+      result.push_back(PathQuery{cities[i]->region, cities[j]->region, model});
+    }
+  }
+  return result;
+}
+
+void PathService::build(std::vector<Region *> &regions,
+                        std::vector<Cluster *> &clusters,
+                        const HeightCache *heights) {
+  clear();
+  hierarchy.heights = heights;
+  hierarchy.build(regions, clusters);
+}
+
+void PathService::clear() {
+  workers.clear();
+  hierarchy.clear();
+  clearMemo();
+}
+
+void PathService::clearMemo() {
+  std::lock_guard<std::mutex> guard(mutex);
+  memo.clear();
+  queries = 0;
+  hits = 0;
+  unreachable = 0;
+  routingTime = sf::Time::Zero;
+}
+
+std::size_t PathService::bytes() const {
+  std::lock_guard<std::mutex> guard(mutex);
+  std::size_t total = hierarchy.bytes();
+  for (auto &pair : memo) {
+    total += sizeof(pair) + pair.second.capacity() * sizeof(Region *) + 32;
+  }
+  return total;
+}
+
+float PathService::hitRate() const {
+  return queries > 0 ? float(hits) / queries : 0.f;
+}
@@ -0,0 +1,51 @@
+#include <cmath>
+
+#include "mapgen/RegionGraph.hpp"
+#include "mapgen/MapGenerator.hpp"
+#include "mapgen/utils.hpp"
+
+RegionGraph::RegionGraph(CostModel m) : model(m) {}
+
+// Land routes stay on land and pay for slopes; sea routes stay on water
+// and enter or leave it through ports. Passability does not depend on the
+// query, so a pather's cache stays valid for every query of its model.
+bool RegionGraph::passable(Region *region) const {
+  bool land = region->megaCluster->isLand;
+  if (model == LAND_ROUTE) {
+    return land;
+  }
+  return !land || (region->city != nullptr && region->city->type == PORT);
+}
+
+float RegionGraph::cost(Region *from, Region *to) const {
+  float d = mg::getDistance(from->site, to->site);
+  if (model == SEA_ROUTE) {
+    return d;
+  }
+  float dh = heights != nullptr
+                 ? std::abs(heights->site(to) - heights->site(from))
+                 : std::abs(to->getHeight(to->site) - from->getHeight(from->site));
+  return d * (1.f + dh * 10.f);
+}
+
+float RegionGraph::LeastCostEstimate(void *start, void *end) {
+  return mg::getDistance(static_cast<Region *>(start)->site,
+                         static_cast<Region *>(end)->site);
+}
+
+void RegionGraph::AdjacentCost(void *state,
+                               MP_VECTOR<micropather::StateCost> *adjacent) {
+  auto region = static_cast<Region *>(state);
+  for (auto n : region->neighbors) {
+    if (!passable(n)) {
+      continue;
+    }
+    micropather::StateCost c = {static_cast<void *>(n), cost(region, n)};
+    adjacent->push_back(c);
+  }
+}
+
+void RegionGraph::PrintStateInfo(void *state) {
+  auto region = static_cast<Region *>(state);
+  mg::info("Region:", region->biom.name);
+}
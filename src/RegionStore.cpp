@@ -0,0 +1,75 @@
+#include "mapgen/RegionStore.hpp"
+#include "mapgen/MapGenerator.hpp"
+
+void RegionStore::build(std::vector<Region *> &regions,
+                        std::vector<Cluster *> &clusters) {
+  clear();
+  std::uint32_t n = std::uint32_t(regions.size());
+  index.reserve(n);
+  for (std::uint32_t i = 0; i < n; i++) {
+    index[regions[i]] = i;
+  }
+  std::unordered_map<Cluster *, std::uint32_t> clusterIndex;
+  for (std::uint32_t i = 0; i < std::uint32_t(clusters.size()); i++) {
+    clusterIndex[clusters[i]] = i;
+  }
+
+  x.resize(n);
+  y.resize(n);
+  cluster.resize(n);
+  land.resize(n);
+  vertexStart.reserve(n + 1);
+  neighborStart.reserve(n + 1);
+  vertexStart.push_back(0);
+  neighborStart.push_back(0);
+  for (std::uint32_t i = 0; i < n; i++) {
+    auto region = regions[i];
+    x[i] = float(region->site->x);
+    y[i] = float(region->site->y);
+    auto c = clusterIndex.find(region->cluster);
+    cluster[i] = c == clusterIndex.end() ? UINT32_MAX : c->second;
+    land[i] = region->megaCluster->isLand ? 1 : 0;
+    for (auto p : region->getPoints()) {
+      vx.push_back(float(p->x));
+      vy.push_back(float(p->y));
+    }
+    vertexStart.push_back(std::uint32_t(vx.size()));
+    for (auto nb : region->neighbors) {
+      auto it = index.find(nb);
+      if (it != index.end()) {
+        neighbors.push_back(it->second);
+      }
+    }
+    neighborStart.push_back(std::uint32_t(neighbors.size()));
+  }
+}
+
+void RegionStore::clear() {
+  x.clear();
+  y.clear();
+  vertexStart.clear();
+  vx.clear();
+  vy.clear();
+  neighborStart.clear();
+  neighbors.clear();
+  cluster.clear();
+  land.clear();
+  index.clear();
+}
+
+std::size_t RegionStore::size() const { return x.size(); }
+
+std::size_t RegionStore::bytes() const {
+  return (x.capacity() + y.capacity() + vx.capacity() + vy.capacity()) *
+             sizeof(float) +
+         (vertexStart.capacity() + neighborStart.capacity() +
+          neighbors.capacity() + cluster.capacity()) *
+             sizeof(std::uint32_t) +
+         land.capacity() +
+         index.size() * (sizeof(Region *) + sizeof(std::uint32_t) + 16);
+}
+
+int RegionStore::indexOf(Region *region) const {
+  auto it = index.find(region);
+  return it == index.end() ? -1 : int(it->second);
+}
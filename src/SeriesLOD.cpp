@@ -0,0 +1,126 @@
+#include <algorithm>
+
+#include "mapgen/SeriesLOD.hpp"
+
+SeriesLOD::SeriesLOD(int bits) : chunkBits(bits), chunkSize(1u << bits) {}
+
+// Appends samples the source got since the last call. A shorter source or
+// a changed last sample means the report was reset, so the series restarts.
+// Returns true if anything changed.
+bool SeriesLOD::sync(const std::vector<float> &source) {
+  if (source.size() < count ||
+      (count > 0 && source[count - 1] != at(count - 1))) {
+    clear();
+  }
+  if (source.size() == count) {
+    return false;
+  }
+  for (std::size_t i = count; i < source.size(); i++) {
+    push(source[i]);
+  }
+  return true;
+}
+
+void SeriesLOD::push(float value) {
+  if ((count & (chunkSize - 1)) == 0) {
+    chunks.push_back(std::vector<float>());
+    chunks.back().reserve(chunkSize);
+  }
+  chunks.back().push_back(value);
+  low = count == 0 ? value : std::min(low, value);
+  high = count == 0 ? value : std::max(high, value);
+  count++;
+
+  // Every completed pair at one level adds an element to the next.
+  std::size_t i = count - 1;
+  if (i % 2 == 0) {
+    dirty = true;
+    return;
+  }
+  float lo = std::min(at(i - 1), value);
+  float hi = std::max(at(i - 1), value);
+  for (int level = 0;; level++) {
+    if (int(mins.size()) == level) {
+      mins.push_back(std::vector<float>());
+      maxs.push_back(std::vector<float>());
+    }
+    mins[level].push_back(lo);
+    maxs[level].push_back(hi);
+    std::size_t j = mins[level].size() - 1;
+    if (j % 2 == 0) {
+      break;
+    }
+    lo = std::min(mins[level][j - 1], lo);
+    hi = std::max(maxs[level][j - 1], hi);
+  }
+  dirty = true;
+}
+
+void SeriesLOD::clear() {
+  count = 0;
+  chunks.clear();
+  mins.clear();
+  maxs.clear();
+  plot.clear();
+  dirty = true;
+}
+
+std::size_t SeriesLOD::size() const { return count; }
+
+float SeriesLOD::at(std::size_t i) const {
+  return chunks[i >> chunkBits][i & (chunkSize - 1)];
+}
+
+float SeriesLOD::front() const { return count > 0 ? at(0) : 0.f; }
+
+float SeriesLOD::back() const { return count > 0 ? at(count - 1) : 0.f; }
+
+float SeriesLOD::min() const { return count > 0 ? low : 0.f; }
+
+float SeriesLOD::max() const { return count > 0 ? high : 0.f; }
+
+// At most `points` values: the raw samples if they fit, otherwise min and
+// max of power-of-two buckets taken from the pyramid. Rebuilt only when
+// the series or the point count changes.
+const std::vector<float> &SeriesLOD::downsample(int points) {
+  if (!dirty && points == plotPoints) {
+    return plot;
+  }
+  dirty = false;
+  plotPoints = points;
+  plot.clear();
+
+  if (count <= std::size_t(std::max(points, 2))) {
+    for (std::size_t i = 0; i < count; i++) {
+      plot.push_back(at(i) * scale);
+    }
+    return plot;
+  }
+
+  int level = 0;
+  while (level + 1 < int(mins.size()) &&
+         mins[level].size() * 2 > std::size_t(points)) {
+    level++;
+  }
+  std::size_t bucket = std::size_t(2) << level;
+  for (std::size_t j = 0; j < mins[level].size(); j++) {
+    bool rising = j + 1 < mins[level].size() &&
+                  mins[level][j + 1] + maxs[level][j + 1] >
+                      mins[level][j] + maxs[level][j];
+    plot.push_back((rising ? mins[level][j] : maxs[level][j]) * scale);
+    plot.push_back((rising ? maxs[level][j] : mins[level][j]) * scale);
+  }
+
+  std::size_t tail = mins[level].size() * bucket;
+  if (tail < count) {
+    float lo = at(tail);
+    float hi = at(tail);
+    for (std::size_t i = tail; i < count; i++) {
+      lo = std::min(lo, at(i));
+      hi = std::max(hi, at(i));
+    }
+    plot.push_back(lo * scale);
+    plot.push_back(hi * scale);
+  }
+  return plot;
+}
@@ -0,0 +1,70 @@
+#include "mapgen/SimulationSnapshot.hpp"
+
+void SimulationSnapshot::capture(MapGenerator *gen) {
+  auto &cities = gen->map->cities;
+  auto &regions = gen->map->regions;
+  population.resize(cities.size());
+  wealth.resize(cities.size());
+  traffic.resize(regions.size());
+  cityKeys = cities;
+  regionKeys = regions;
+  for (int i = 0; i < int(cities.size()); i++) {
+    population[i] = cities[i]->population;
+    wealth[i] = cities[i]->wealth;
+  }
+  for (int i = 0; i < int(regions.size()); i++) {
+    traffic[i] = regions[i]->traffic;
+  }
+  reported = gen->simulator->report != nullptr;
+  report = reported ? *gen->simulator->report : Report();
+}
+
+// Returns false (and leaves the map untouched) if the snapshot was taken
+// on a different map.
+bool SimulationSnapshot::restore(MapGenerator *gen) const {
+  if (!matches(gen)) {
+    return false;
+  }
+  auto &cities = gen->map->cities;
+  auto &regions = gen->map->regions;
+  for (int i = 0; i < int(cities.size()); i++) {
+    cities[i]->population = population[i];
+    cities[i]->wealth = wealth[i];
+  }
+  for (int i = 0; i < int(regions.size()); i++) {
+    regions[i]->traffic = traffic[i];
+  }
+  if (gen->simulator->report != nullptr) {
+    *gen->simulator->report = report;
+  }
+  return true;
+}
+
+// The snapshot belongs to the map whose city and region objects it was
+// taken from, in the same order.
+bool SimulationSnapshot::matches(MapGenerator *gen) const {
+  return !empty() && cityKeys == gen->map->cities &&
+         regionKeys == gen->map->regions;
+}
+
+void SimulationSnapshot::clear() {
+  cityKeys.clear();
+  regionKeys.clear();
+  population.clear();
+  wealth.clear();
+  traffic.clear();
+  reported = false;
+  report = Report();
+}
+
+bool SimulationSnapshot::empty() const { return traffic.size() == 0; }
+
+std::size_t SimulationSnapshot::bytes() const {
+  return population.size() * sizeof(population[0]) +
+         wealth.size() * sizeof(wealth[0]) +
+         traffic.size() * sizeof(traffic[0]) +
+         cityKeys.size() * sizeof(City *) +
+         regionKeys.size() * sizeof(Region *) +
+         report.population.capacity() * sizeof(report.population[0]) +
+         report.wealth.capacity() * sizeof(report.wealth[0]);
+}
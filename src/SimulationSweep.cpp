@@ -0,0 +1,214 @@
+#include <cstdlib>
+#include <fstream>
+
+#include <SFML/System/Clock.hpp>
+#include "mapgen/Random.hpp"
+#include "mapgen/SimulationSweep.hpp"
+#include "mapgen/utils.hpp"
+
+SimulationSweep::SimulationSweep(MapGenerator *m) : mapgen(m) {
+  for (auto name :
+       {"POPULATION_GROWS", "POPULATION_GROWS_WEALTH_MODIFIER",
+        "PACKAGES_PER_NICE", "PACKAGES_AGRO_POPULATION_MODIFIER",
+        "PACKAGES_PER_MINERALS", "PACKAGES_MINERALS_POPULATION_MODIFIER",
+        "CONSUME_AGRO_POPULATION_MODIFIER",
+        "CONSUME_MINERALS_POPULATION_MODIFIER", "CONSUME_AGRO_WEALTH_MODIFIER",
+        "CONSUME_MINERALS_WEALTH_MODIFIER", "CANT_BUY_AGRO",
+        "CANT_BUY_MINERALS", "MINERALS_POPULATION_PRODUCE",
+        "AGRO_POPULATION_PRODUCE", "PORT_FEE", "PRICE_CORRECTION"}) {
+    SweepParam param;
+    param.name = name;
+    float value = *var(name);
+    param.from = value * 0.5f;
+    param.to = value * 1.5f;
+    params.push_back(param);
+  }
+}
+
+void SimulationSweep::setMapGenerator(MapGenerator *m) { mapgen = m; }
+
+float *SimulationSweep::var(std::string name) {
+  auto vars = mapgen->simulator->vars;
+#define SWEEP_VAR(n)                                                           \
+  if (name == #n)                                                              \
+    return &vars->n;
+  SWEEP_VAR(POPULATION_GROWS)
+  SWEEP_VAR(POPULATION_GROWS_WEALTH_MODIFIER)
+  SWEEP_VAR(PACKAGES_PER_NICE)
+  SWEEP_VAR(PACKAGES_AGRO_POPULATION_MODIFIER)
+  SWEEP_VAR(PACKAGES_PER_MINERALS)
+  SWEEP_VAR(PACKAGES_MINERALS_POPULATION_MODIFIER)
+  SWEEP_VAR(CONSUME_AGRO_POPULATION_MODIFIER)
+  SWEEP_VAR(CONSUME_MINERALS_POPULATION_MODIFIER)
+  SWEEP_VAR(CONSUME_AGRO_WEALTH_MODIFIER)
+  SWEEP_VAR(CONSUME_MINERALS_WEALTH_MODIFIER)
+  SWEEP_VAR(CANT_BUY_AGRO)
+  SWEEP_VAR(CANT_BUY_MINERALS)
+  SWEEP_VAR(MINERALS_POPULATION_PRODUCE)
+  SWEEP_VAR(AGRO_POPULATION_PRODUCE)
+  SWEEP_VAR(PORT_FEE)
+  SWEEP_VAR(PRICE_CORRECTION)
+#undef SWEEP_VAR
+  return nullptr;
+}
+
+// Values of the enabled parameters for every run.
+std::vector<std::vector<float>> SimulationSweep::combinations() {
+  std::vector<SweepParam *> enabled;
+  for (auto &p : params) {
+    if (p.enabled) {
+      enabled.push_back(&p);
+    }
+  }
+
+  std::vector<std::vector<float>> result;
+  if (enabled.size() == 0) {
+    result.push_back({});
+    return result;
+  }
+
+  if (random) {
+    RandomStream random(seed, "sweep");
+    for (int i = 0; i < samples; i++) {
+      std::vector<float> values;
+      for (int j = 0; j < int(enabled.size()); j++) {
+        auto p = enabled[j];
+        values.push_back(random.range(i, j, std::min(p->from, p->to),
+                                      std::max(p->from, p->to)));
+      }
+      result.push_back(values);
+    }
+    return result;
+  }
+
+  result.push_back({});
+  for (auto p : enabled) {
+    std::vector<std::vector<float>> next;
+    int steps = std::max(1, p->steps);
+    for (auto &values : result) {
+      for (int s = 0; s < steps; s++) {
+        float t = steps == 1 ? 0.f : float(s) / (steps - 1);
+        auto v = values;
+        v.push_back(p->from + (p->to - p->from) * t);
+        next.push_back(v);
+      }
+    }
+    result = next;
+  }
+  return result;
+}
+
+namespace {
+struct RunResult {
+  float ms = 0.f;
+  unsigned int seed = 0;
+  bool reported = false;
+  int minPopulation = 0;
+  int maxPopulation = 0;
+  float minWealth = 0.f;
+  float maxWealth = 0.f;
+  std::vector<float> population;
+  std::vector<float> wealth;
+};
+} // namespace
+
+// Stops after the run in progress; the rows done so far are written.
+void SimulationSweep::cancel() { cancelled = true; }
+
+// Runs on the generator thread. The viewer leaves the simulation state
+// alone while it runs (see Application::updateSweep).
+void SimulationSweep::run() {
+  auto runs = combinations();
+  done = 0;
+  total = int(runs.size());
+  cancelled = false;
+
+  std::vector<SweepParam *> enabled;
+  for (auto &p : params) {
+    if (p.enabled) {
+      enabled.push_back(&p);
+    }
+  }
+
+  sf::Clock sweepClock;
+  SimulationSnapshot before;
+  before.capture(mapgen);
+  const SimulationSnapshot &start =
+      pristine != nullptr && pristine->matches(mapgen) ? *pristine : before;
+  std::vector<float> base;
+  for (auto &p : params) {
+    base.push_back(*var(p.name));
+  }
+
+  std::vector<RunResult> results;
+  for (int r = 0; r < int(runs.size()) && !cancelled; r++) {
+    for (int i = 0; i < int(enabled.size()); i++) {
+      *var(enabled[i]->name) = runs[r][i];
+    }
+    start.restore(mapgen);
+    RunResult result;
+    result.seed = unsigned(mapgen->getSeed()) + unsigned(r);
+    std::srand(result.seed);
+    sf::Clock clock;
+    mapgen->startSimulation();
+    result.ms = clock.getElapsedTime().asMicroseconds() / 1000.f;
+    auto report = mapgen->simulator->report;
+    if (report != nullptr) {
+      result.reported = true;
+      result.minPopulation = report->minPopulation;
+      result.maxPopulation = report->maxPopulation;
+      result.minWealth = report->minWealth;
+      result.maxWealth = report->maxWealth;
+      result.population = report->population;
+      result.wealth = report->wealth;
+    }
+    results.push_back(result);
+    done++;
+  }
+
+  for (int i = 0; i < int(params.size()); i++) {
+    *var(params[i].name) = base[i];
+  }
+  before.restore(mapgen);
+
+  std::ofstream out(path);
+  out << "run";
+  for (auto p : enabled) {
+    out << "," << p->name;
+  }
+  out << ",seed,ms,steps,minPopulation,maxPopulation,minWealth,maxWealth\n";
+  std::ofstream series(seriesPath);
+  series << "run,step,population,wealth\n";
+  for (int r = 0; r < int(results.size()); r++) {
+    auto &result = results[r];
+    out << r;
+    for (auto v : runs[r]) {
+      out << "," << v;
+    }
+    out << "," << result.seed << "," << result.ms;
+    if (!result.reported) {
+      out << ",0,,,,\n";
+      continue;
+    }
+    out << "," << result.population.size() << "," << result.minPopulation
+        << "," << result.maxPopulation << "," << result.minWealth << ","
+        << result.maxWealth << "\n";
+    auto steps = std::max(result.population.size(), result.wealth.size());
+    for (std::size_t i = 0; i < steps; i++) {
+      series << r << "," << i << ",";
+      if (i < result.population.size()) {
+        series << result.population[i];
+      }
+      series << ",";
+      if (i < result.wealth.size()) {
+        series << result.wealth[i];
+      }
+      series << "\n";
+    }
+  }
+
+  float seconds = sweepClock.getElapsedTime().asSeconds();
+  msPerRun = results.size() > 0 ? seconds * 1000.f / results.size() : 0.f;
+  runsPerSecond = seconds > 0.f ? results.size() / seconds : 0.f;
+  mg::info("Sweep finished, runs:", int(results.size()));
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "mapgen/StageCache.hpp"
+#include "mapgen/utils.hpp"
+
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+
+namespace {
+const unsigned int CACHE_MAGIC = 0x4353474d; // "MGSC"
+const unsigned int CACHE_VERSION = 1;
+} // namespace
+
+StageCache::StageCache(std::string d, int k) : dir(d), keep(k) {
+  usage = scan();
+}
+
+std::string StageCache::file(const std::string &stage,
+                             std::uint64_t key) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+  return (fs::path(dir) / (stage + "-" + name)).string();
+}
+
+// The file header repeats the key, so a truncated or foreign file is
+// treated as a miss.
+bool StageCache::read(const std::string &stage, std::uint64_t key,
+                      std::function<bool(std::istream &)> fn) {
+  if (!enabled) {
+    return false;
+  }
+  std::ifstream in(file(stage, key), std::ios::binary);
+  bool hit = in && get<unsigned int>(in) == CACHE_MAGIC &&
+             get<unsigned int>(in) == CACHE_VERSION &&
+             get<std::uint64_t>(in) == key && fn(in);
+  if (hit) {
+    hits++;
+    mg::info("Stage cache hit:", stage);
+  } else {
+    misses++;
+  }
+  return hit;
+}
+
+// Written to a temporary file first, so readers never see a partial entry.
+// The temporary name is per thread, as the preview and generator threads
+// may write the same entry at once.
+void StageCache::write(const std::string &stage, std::uint64_t key,
+                       std::function<void(std::ostream &)> fn) {
+  if (!enabled) {
+    return;
+  }
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  auto path = file(stage, key);
+  auto tmp = path + "." +
+             std::to_string(std::hash<std::thread::id>()(
+                 std::this_thread::get_id())) +
+             ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      mg::warn("Cannot write stage cache:", path);
+      return;
+    }
+    put<unsigned int>(out, CACHE_MAGIC);
+    put<unsigned int>(out, CACHE_VERSION);
+    put<std::uint64_t>(out, key);
+    fn(out);
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  fs::rename(tmp, path, ec);
+  if (ec) {
+    mg::warn("Cannot write stage cache:", path);
+    fs::remove(tmp, ec);
+  }
+  prune(stage);
+  usage = scan();
+}
+
+void StageCache::prune(const std::string &stage) {
+  std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+  std::error_code ec;
+  for (auto &d : fs::directory_iterator(dir, ec)) {
+    auto name = d.path().filename().string();
+    if (name.compare(0, stage.size() + 1, stage + "-") == 0 &&
+        d.path().extension() == ".bin") {
+      entries.push_back(
+          std::make_pair(fs::last_write_time(d.path(), ec), d.path()));
+    }
+  }
+  if (int(entries.size()) <= keep) {
+    return;
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const std::pair<fs::file_time_type, fs::path> &a,
+               const std::pair<fs::file_time_type, fs::path> &b) {
+              return a.first > b.first;
+            });
+  for (int i = keep; i < int(entries.size()); i++) {
+    fs::remove(entries[i].second, ec);
+  }
+}
+
+void StageCache::purge() {
+  std::lock_guard<std::mutex> guard(lock);
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+  hits = 0;
+  misses = 0;
+  usage = 0;
+}
+
+std::size_t StageCache::diskBytes() const { return usage; }
+
+std::size_t StageCache::scan() const {
+  std::size_t total = 0;
+  std::error_code ec;
+  for (auto &d : fs::directory_iterator(dir, ec)) {
+    auto size = fs::file_size(d.path(), ec);
+    if (!ec) {
+      total += size;
+    }
+  }
+  return total;
+}
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mapgen/TileMesh.hpp"
+
+TileMesh::TileMesh(float t) : tileSize(t) {}
+
+// Every polygon belongs to the tile that holds its site; polygons are
+// small, so the overlap into neighbours is fine for culling.
+void TileMesh::build(const RegionStore &s, const std::vector<sf::Color> &c,
+                     const std::vector<char> &include, sf::Vector2f o,
+                     float width, float height) {
+  store = &s;
+  colors = c;
+  offset = o;
+  columns = std::max(1, int(std::ceil(width / tileSize)));
+  rows = std::max(1, int(std::ceil(height / tileSize)));
+  int count = columns * rows;
+
+  std::vector<int> owner(s.size(), -1);
+  tileStart.assign(count + 1, 0);
+  for (std::size_t i = 0; i < s.size(); i++) {
+    if (!include[i]) {
+      continue;
+    }
+    int tx = std::min(columns - 1, std::max(0, int(s.x[i] / tileSize)));
+    int ty = std::min(rows - 1, std::max(0, int(s.y[i] / tileSize)));
+    owner[i] = ty * columns + tx;
+    tileStart[owner[i] + 1]++;
+  }
+  for (int t = 0; t < count; t++) {
+    tileStart[t + 1] += tileStart[t];
+  }
+  tileRegions.resize(tileStart[count]);
+  std::vector<std::uint32_t> next(tileStart.begin(), tileStart.end() - 1);
+  for (std::size_t i = 0; i < s.size(); i++) {
+    if (owner[i] != -1) {
+      tileRegions[next[owner[i]]++] = std::uint32_t(i);
+    }
+  }
+
+  tiles.assign(count, sf::VertexArray(sf::Triangles));
+  resident.assign(count, 0);
+  lastSeen.assign(count, 0);
+  frame = 0;
+}
+
+// Fans every polygon of the tile from its first vertex.
+void TileMesh::fill(int t) {
+  auto &tile = tiles[t];
+  tile.clear();
+  for (std::uint32_t k = tileStart[t]; k < tileStart[t + 1]; k++) {
+    std::uint32_t i = tileRegions[k];
+    std::uint32_t begin = store->vertexStart[i];
+    std::uint32_t end = store->vertexStart[i + 1];
+    sf::Vector2f first(store->vx[begin], store->vy[begin]);
+    for (std::uint32_t v = begin + 1; v + 1 < end; v++) {
+      tile.append(sf::Vertex(first + offset, colors[i]));
+      tile.append(sf::Vertex(
+          sf::Vector2f(store->vx[v], store->vy[v]) + offset, colors[i]));
+      tile.append(sf::Vertex(
+          sf::Vector2f(store->vx[v + 1], store->vy[v + 1]) + offset,
+          colors[i]));
+    }
+  }
+  resident[t] = 1;
+}
+
+// Makes every visible tile resident, then evicts hidden ones until the
+// mesh fits the budget. Visible tiles are never evicted, so the view is
+// always complete even when it alone exceeds the budget.
+void TileMesh::stream(const sf::FloatRect &visible) {
+  frame++;
+  for (int t = 0; t < int(tiles.size()); t++) {
+    if (!visible.intersects(bounds(t))) {
+      continue;
+    }
+    if (!resident[t]) {
+      fill(t);
+    }
+    lastSeen[t] = frame;
+  }
+
+  std::vector<int> hidden;
+  for (int t = 0; t < int(tiles.size()); t++) {
+    if (resident[t] && lastSeen[t] != frame) {
+      hidden.push_back(t);
+    }
+  }
+  std::sort(hidden.begin(), hidden.end(),
+            [&](int a, int b) { return lastSeen[a] < lastSeen[b]; });
+  std::size_t total = bytes();
+  for (int t : hidden) {
+    if (total <= budget) {
+      break;
+    }
+    total -= tiles[t].getVertexCount() * sizeof(sf::Vertex);
+    tiles[t] = sf::VertexArray(sf::Triangles);
+    resident[t] = 0;
+  }
+}
+
+void TileMesh::clear() {
+  tiles.clear();
+  resident.clear();
+  lastSeen.clear();
+  tileStart.clear();
+  tileRegions.clear();
+  colors.clear();
+  store = nullptr;
+  columns = 0;
+  rows = 0;
+}
+
+std::size_t TileMesh::bytes() const {
+  std::size_t total =
+      (tileStart.capacity() + tileRegions.capacity() + lastSeen.capacity()) *
+          sizeof(std::uint32_t) +
+      colors.capacity() * sizeof(sf::Color) + resident.capacity();
+  for (auto &tile : tiles) {
+    total += tile.getVertexCount() * sizeof(sf::Vertex);
+  }
+  return total;
+}
+
+int TileMesh::tileCount() const { return int(tiles.size()); }
+
+int TileMesh::residentCount() const {
+  return int(std::count(resident.begin(), resident.end(), 1));
+}
+
+// Polygons may reach into the next tile, so tiles are widened a bit.
+sf::FloatRect TileMesh::bounds(int t) const {
+  float margin = tileSize / 4.f;
+  int tx = t % columns;
+  int ty = t / columns;
+  return sf::FloatRect(tx * tileSize - margin + offset.x,
+                       ty * tileSize - margin + offset.y,
+                       tileSize + 2 * margin, tileSize + 2 * margin);
+}
+
+void TileMesh::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+  auto view = target.getView();
+  sf::FloatRect visible(view.getCenter() - view.getSize() / 2.f,
+                        view.getSize());
+  for (int t = 0; t < int(tiles.size()); t++) {
+    if (resident[t] && visible.intersects(bounds(t))) {
+      target.draw(tiles[t], states);
+    }
+  }
+}
@@ -0,0 +1,210 @@
+#include "mapgen/WalkerSystem.hpp"
+#include "mapgen/City.hpp"
+#include "mapgen/MapGenerator.hpp"
+#include "mapgen/utils.hpp"
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <random>
+
+namespace {
+const sf::Color fillColor(225, 225, 190);
+const sf::Color outlineColor = sf::Color::Black;
+
+void setQuad(sf::VertexArray &vertices, int offset, sf::Vector2f center,
+             float r) {
+  vertices[offset].position = center + sf::Vector2f(-r, -r);
+  vertices[offset + 1].position = center + sf::Vector2f(r, -r);
+  vertices[offset + 2].position = center + sf::Vector2f(r, r);
+  vertices[offset + 3].position = center + sf::Vector2f(-r, r);
+}
+} // namespace
+
+WalkerSystem::WalkerSystem(MapGenerator *m) : mapgen(m), vertices(sf::Quads) {}
+
+void WalkerSystem::setMapGenerator(MapGenerator *m) {
+  mapgen = m;
+  clear();
+}
+
+void WalkerSystem::clear() {
+  roadStart.clear();
+  roadPoints.clear();
+  roadFrom.clear();
+  roadTo.clear();
+  points.clear();
+  arc.clear();
+  cityStart.clear();
+  cityRoads.clear();
+  agentRoad.clear();
+  agentSegment.clear();
+  agentDistance.clear();
+  agentSpeed.clear();
+  agentReverse.clear();
+  vertices.clear();
+  initialized = false;
+}
+
+std::size_t WalkerSystem::size() const { return agentRoad.size(); }
+
+void WalkerSystem::init(unsigned int seed, int count,
+                        std::map<Road *, sw::Spline *> &splines) {
+  clear();
+  random = RandomStream(seed, "walkers");
+  initialized = true;
+
+  std::map<City *, int> cityIndex;
+  for (auto c : mapgen->map->cities) {
+    cityIndex.insert(std::make_pair(c, int(cityIndex.size())));
+  }
+  auto indexOf = [&](City *c) {
+    auto i = cityIndex.find(c);
+    return i == cityIndex.end() ? -1 : i->second;
+  };
+
+  std::map<Road *, int> roadIndex;
+  for (auto &p : mapgen->map->roadMap) {
+    Road *road = p.second;
+    if (road->regions.size() < 2 || roadIndex.count(road) != 0) {
+      continue;
+    }
+    int r = int(roadStart.size());
+    int start = int(points.size());
+    roadIndex[road] = r;
+    roadStart.push_back(start);
+
+    auto spline = splines.find(road);
+    if (spline != splines.end() &&
+        spline->second->getInterpolatedPositionCount() > 1) {
+      auto n = spline->second->getInterpolatedPositionCount();
+      for (unsigned int i = 0; i < n; i++) {
+        points.push_back(spline->second->getInterpolatedPosition(i));
+      }
+    } else {
+      for (auto region : road->regions) {
+        points.push_back(sf::Vector2f(static_cast<float>(region->site->x),
+                                      static_cast<float>(region->site->y)));
+      }
+    }
+    roadPoints.push_back(int(points.size()) - start);
+
+    float length = 0.f;
+    for (int i = start; i < int(points.size()); i++) {
+      if (i > start) {
+        auto d = points[i] - points[i - 1];
+        length += std::sqrt(d.x * d.x + d.y * d.y);
+      }
+      arc.push_back(length);
+    }
+
+    roadFrom.push_back(indexOf(road->regions.front()->city));
+    roadTo.push_back(indexOf(road->regions.back()->city));
+  }
+
+  std::vector<int> sources;
+  for (auto c : mapgen->map->cities) {
+    cityStart.push_back(int(cityRoads.size()));
+    for (auto road : c->roads) {
+      auto r = roadIndex.find(road);
+      if (r != roadIndex.end()) {
+        cityRoads.push_back(r->second);
+      }
+    }
+    if (int(cityRoads.size()) > cityStart.back()) {
+      sources.push_back(int(cityStart.size()) - 1);
+    }
+  }
+  cityStart.push_back(int(cityRoads.size()));
+
+  if (sources.size() == 0) {
+    return;
+  }
+  if (count <= 0) {
+    count = int(sources.size());
+  }
+
+  agentRoad.resize(count);
+  agentSegment.resize(count);
+  agentDistance.resize(count);
+  agentSpeed.resize(count);
+  agentReverse.resize(count);
+  agentDraws.assign(count, 0);
+  vertices.resize(count * 8);
+
+  for (int i = 0; i < count; i++) {
+    agentSpeed[i] = speed * random.range(i, agentDraws[i]++, 0.8f, 1.2f);
+    pickRoad(i, sources[i % sources.size()]);
+    for (int v = 0; v < 4; v++) {
+      vertices[i * 8 + v].color = outlineColor;
+      vertices[i * 8 + 4 + v].color = fillColor;
+    }
+    place(i);
+  }
+  mg::info("Walkers:", count);
+}
+
+// Leaves the agent at the start of a random road of the city,
+// or turns it around if the road ends nowhere.
+void WalkerSystem::pickRoad(int agent, int city) {
+  int n = city < 0 ? 0 : cityStart[city + 1] - cityStart[city];
+  if (n == 0) {
+    agentReverse[agent] = !agentReverse[agent];
+    return;
+  }
+  int r = cityRoads[cityStart[city] + random.below(agent, agentDraws[agent]++, n)];
+  bool reverse = roadTo[r] == city;
+  agentRoad[agent] = r;
+  agentReverse[agent] = reverse;
+  agentSegment[agent] = reverse ? roadPoints[r] - 2 : 0;
+  agentDistance[agent] = reverse ? arc[roadStart[r] + roadPoints[r] - 1] : 0.f;
+}
+
+void WalkerSystem::tick(float dt) {
+  for (int i = 0; i < int(agentRoad.size()); i++) {
+    int r = agentRoad[i];
+    float length = arc[roadStart[r] + roadPoints[r] - 1];
+    float step = agentSpeed[i] * dt;
+    float d = agentDistance[i] + (agentReverse[i] ? -step : step);
+
+    if (!agentReverse[i] && d >= length) {
+      agentDistance[i] = length;
+      pickRoad(i, roadTo[r]);
+    } else if (agentReverse[i] && d <= 0.f) {
+      agentDistance[i] = 0.f;
+      pickRoad(i, roadFrom[r]);
+    } else {
+      agentDistance[i] = d;
+    }
+    place(i);
+  }
+}
+
+void WalkerSystem::place(int i) {
+  int r = agentRoad[i];
+  int start = roadStart[r];
+  int last = roadPoints[r] - 2;
+  int s = std::max(0, std::min(agentSegment[i], last));
+  float d = agentDistance[i];
+  while (s < last && arc[start + s + 1] < d) {
+    s++;
+  }
+  while (s > 0 && arc[start + s] > d) {
+    s--;
+  }
+  agentSegment[i] = s;
+
+  float a = arc[start + s];
+  float b = arc[start + s + 1];
+  float t = b > a ? (d - a) / (b - a) : 0.f;
+  auto p = points[start + s] + (points[start + s + 1] - points[start + s]) * t;
+
+  setQuad(vertices, i * 8, p, radius + 1.f);
+  setQuad(vertices, i * 8 + 4, p, radius);
+}
+
+void WalkerSystem::draw(sf::RenderTarget &target,
+                        sf::RenderStates states) const {
+  if (vertices.getVertexCount() == 0) {
+    return;
+  }
+  target.draw(vertices, states);
+}
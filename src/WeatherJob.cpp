@@ -0,0 +1,112 @@
+#include <unordered_map>
+
+#include "mapgen/WeatherJob.hpp"
+#include "mapgen/WeatherManager.hpp"
+#include "mapgen/utils.hpp"
+
+WeatherJob::~WeatherJob() {
+  cancel();
+  wait();
+}
+
+void WeatherJob::start(MapGenerator *m, float a, float f) {
+  cancel();
+  wait();
+  mapgen = m;
+  angle = a;
+  force = f;
+  field = nullptr;
+  done = false;
+  cancelled = false;
+  worker = std::thread([this]() {
+    run();
+    done = true;
+  });
+}
+
+void WeatherJob::cancel() { cancelled = true; }
+
+void WeatherJob::wait() {
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+bool WeatherJob::running() const { return worker.joinable(); }
+
+bool WeatherJob::finished() const { return done; }
+
+// calcHumidity and calcTemp only write the humidity and temperature of the
+// regions they get, so copies with their neighbours pointing at each other
+// are enough; clusters, heights and the rest stay shared and read-only.
+void WeatherJob::run() {
+  sf::Clock clock;
+  auto &regions = mapgen->map->regions;
+  int n = int(regions.size());
+  std::unordered_map<Region *, int> index;
+  index.reserve(n);
+  for (int i = 0; i < n; i++) {
+    index[regions[i]] = i;
+  }
+  std::vector<Region> copies;
+  copies.reserve(n);
+  for (auto r : regions) {
+    copies.push_back(*r);
+  }
+  std::vector<Region *> pointers(n);
+  for (int i = 0; i < n; i++) {
+    pointers[i] = &copies[i];
+    for (auto &neighbor : copies[i].neighbors) {
+      auto it = index.find(neighbor);
+      if (it != index.end()) {
+        neighbor = &copies[it->second];
+      }
+    }
+  }
+  if (cancelled) {
+    return;
+  }
+
+  WeatherManager weather = *mapgen->weather;
+  weather.windAngle = angle;
+  weather.windForce = force;
+  weather.calcHumidity(pointers);
+  if (cancelled) {
+    return;
+  }
+  weather.calcTemp(pointers);
+  if (cancelled) {
+    return;
+  }
+
+  humidity.resize(n);
+  temperature.resize(n);
+  for (int i = 0; i < n; i++) {
+    humidity[i] = copies[i].humidity;
+    temperature[i] = copies[i].temperature;
+  }
+  auto next = std::make_shared<WindField>();
+  next->build(regions, angle, force);
+  field = next;
+  time = clock.getElapsedTime();
+}
+
+// Returns the downwind table for the new wind, or nullptr if the job was
+// cancelled. The map must be the one the job was started on.
+std::shared_ptr<WindField> WeatherJob::apply() {
+  wait();
+  if (cancelled || field == nullptr) {
+    return nullptr;
+  }
+  auto &regions = mapgen->map->regions;
+  for (int i = 0; i < int(regions.size()); i++) {
+    regions[i]->humidity = humidity[i];
+    regions[i]->temperature = temperature[i];
+  }
+  mapgen->weather->windAngle = angle;
+  mapgen->weather->windForce = force;
+  mg::info("Weather recomputed [ms]:", time.asMilliseconds());
+  auto result = field;
+  field = nullptr;
+  return result;
+}
@@ -0,0 +1,42 @@
+#include "mapgen/WindField.hpp"
+#include "mapgen/Parallel.hpp"
+
+void WindField::build(std::vector<Region *> &regions, float a, float f,
+                      int threads) {
+  sf::Clock clock;
+  int n = int(regions.size());
+  index.clear();
+  index.reserve(n);
+  for (int i = 0; i < n; i++) {
+    index[regions[i]] = i;
+  }
+
+  downwind.assign(n, -1);
+  parallelFor(n,
+              [&](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                  auto r2 = regions[i]->getRegionWithDirection(a, f);
+                  downwind[i] = r2 == nullptr ? -1 : indexOf(r2);
+                }
+              },
+              threads);
+  angle = a;
+  force = f;
+  buildTime = clock.getElapsedTime();
+}
+
+int WindField::indexOf(Region *region) const {
+  auto i = index.find(region);
+  return i == index.end() ? -1 : i->second;
+}
+
+bool WindField::matches(std::vector<Region *> &regions, float a,
+                        float f) const {
+  return angle == a && force == f && downwind.size() == regions.size() &&
+         (regions.size() == 0 || indexOf(regions.front()) == 0);
+}
+
+std::size_t WindField::bytes() const {
+  return downwind.capacity() * sizeof(int) +
+         index.size() * (sizeof(Region *) + sizeof(int) + 16);
+}
@@ -0,0 +1,89 @@
+#include <cmath>
+
+#include "mapgen/WindParticles.hpp"
+
+WindParticles::WindParticles() : vertices(sf::Quads) {}
+
+void WindParticles::clear() {
+  field = nullptr;
+  sites.clear();
+  sources.clear();
+  from.clear();
+  progress.clear();
+  vertices.clear();
+}
+
+bool WindParticles::uses(std::shared_ptr<WindField> f) const {
+  return field == f;
+}
+
+void WindParticles::init(std::shared_ptr<WindField> f,
+                         std::vector<Region *> &regions, int count,
+                         unsigned int seed) {
+  clear();
+  field = f;
+  random = RandomStream(seed, "wind particles");
+
+  sites.resize(regions.size());
+  for (int i = 0; i < int(regions.size()); i++) {
+    sites[i] = sf::Vector2f(static_cast<float>(regions[i]->site->x),
+                            static_cast<float>(regions[i]->site->y));
+    if (regions[i]->cluster->isLand && field->downwind[i] >= 0) {
+      sources.push_back(i);
+    }
+  }
+  if (sources.size() == 0) {
+    return;
+  }
+
+  from.resize(count);
+  progress.resize(count);
+  draws.assign(count, 0);
+  vertices.resize(count * 4);
+  for (int i = 0; i < count; i++) {
+    respawn(i);
+    progress[i] = random.uniform(i, draws[i]++);
+  }
+}
+
+void WindParticles::respawn(int i) {
+  from[i] = sources[random.below(i, draws[i]++, int(sources.size()))];
+  progress[i] = 0.f;
+}
+
+void WindParticles::tick(float dt) {
+  if (sources.size() == 0) {
+    return;
+  }
+  for (int i = 0; i < int(from.size()); i++) {
+    int to = field->downwind[from[i]];
+    auto d = sites[to] - sites[from[i]];
+    float length = std::max(1.f, std::sqrt(d.x * d.x + d.y * d.y));
+    progress[i] += speed * dt / length;
+    if (progress[i] >= 1.f) {
+      from[i] = to;
+      progress[i] = 0.f;
+      if (field->downwind[to] < 0 || random.below(i, draws[i]++, 16) == 0) {
+        respawn(i);
+      }
+      to = field->downwind[from[i]];
+      d = sites[to] - sites[from[i]];
+    }
+
+    auto p = sites[from[i]] + d * progress[i];
+    sf::Color color(200, 230, 255,
+                    static_cast<sf::Uint8>(200 * std::sin(progress[i] * 3.14159265f)));
+    vertices[i * 4] = sf::Vertex(p + sf::Vector2f(-size, -size), color);
+    vertices[i * 4 + 1] = sf::Vertex(p + sf::Vector2f(size, -size), color);
+    vertices[i * 4 + 2] = sf::Vertex(p + sf::Vector2f(size, size), color);
+    vertices[i * 4 + 3] = sf::Vertex(p + sf::Vector2f(-size, size), color);
+  }
+}
+
+void WindParticles::draw(sf::RenderTarget &target,
+                         sf::RenderStates states) const {
+  if (sources.size() == 0) {
+    return;
+  }
+  target.draw(vertices, states);
+}
@@ -1,43 +1,124 @@
+#include "mapgen/DeterminismCheck.hpp"
+#include "mapgen/DistanceRuler.hpp"
+#include "mapgen/MapHasher.hpp"
 #include "mapgen/Painter.hpp"
+#include "mapgen/PathService.hpp"
 #include "mapgen/InfoWindow.hpp"
 #include "mapgen/ObjectsWindow.hpp"
 #include "mapgen/SimulationWindow.hpp"
+#include "mapgen/StageCache.hpp"
+#include "mapgen/WeatherJob.hpp"
 #include "mapgen/WeatherWindow.hpp"
 #include <imgui-SFML.h>
 #include <imgui.h>
+#include <random>
 
 class Application {
+  // Viewer state derived from a generated map. It is built next to the map,
+  // on the generator or the preview thread, and installed in one step.
+  struct PreparedMap {
+    int templateIndex = 0;
+    bool relief = false;
+    int rasterResolution = 0;
+    sf::Vector2u size;
+
+    HeightCache heights;
+    HeightRaster raster;
+    RegionStore store;
+    std::unique_ptr<PathService> paths{new PathService()};
+    SimulationSnapshot pristine;
+    std::vector<std::uint64_t> stages;
+    sf::Time hashTime;
+    sf::Time viewerTime;
+  };
+
   std::string VERSION;
   MapGenerator *mapgen;
   std::thread generator;
+  // Set while a step runs on the generator thread.
+  std::atomic<bool> working{false};
+  WeatherJob weatherJob;
   sf::RenderWindow *window;
+  AssetManager *assets;
+  FrameScheduler scheduler;
+  // Simulation state right after generation; reset restores it.
+  SimulationSnapshot pristine;
+  std::unique_ptr<PathService> paths{new PathService()};
+  DistanceRuler ruler;
+  DeterminismCheck *determinism;
+  MapHasher *hasher;
+  StageCache *stageCache;
   Painter *painter;
   InfoWindow *infoWindow;
-  ObjectsWindow *objectsWindow;
-  SimulationWindow *simulationWindow;
-  WeatherWindow *weatherWindow;
+  ObjectsWindow *objectsWindow = nullptr;
+  SimulationWindow *simulationWindow = nullptr;
+  WeatherWindow *weatherWindow = nullptr;
 
   int relax = 0;
+  sf::Time generationTime;
+  int memoryBudget = 2048;
+  bool largeMapAuto = true;
+  const int largeMapPoints = 200000;
+  sf::Time viewerTime;
   int octaves;
   float freq;
   int nPoints;
   int seed;
+  bool seedGiven;
+  int fixedSeed;
   int t = 0;
+  const char *templates[3] = {"basic", "archipelago", "new"};
+
+  bool livePreview = false;
+  MapGenerator *previewGen = nullptr;
+  std::thread previewWorker;
+  std::shared_ptr<PreparedMap> previewPrepared;
+  std::atomic<bool> previewDone{false};
+  bool previewPending = false;
+  bool previewCancelled = false;
+  sf::Clock previewChanged;
+  std::vector<int> previewLevels;
+  int previewPoints = 2000;
+  float previewBudget = 50.f;
+  const float previewDebounce = 0.15f;
+  sf::Time previewTime;
   bool showUI = true;
   bool getScreenshot = false;
-  bool ready = false;
+  std::atomic<bool> ready{false};
   Region *lockedRegion = nullptr;
   Region *rulerRegion = nullptr;
   bool lock = false;
+  bool dragging = false;
+  sf::Vector2i dragFrom;
+
+  // Idle-aware rendering: frames are only presented while something changes.
+  // Animation alone (walkers, wind particles) is presented at a reduced
+  // rate, so the loop still sleeps between its frames.
+  bool idleRedraw = true;
+  int redraw = 0;
+  const int settleFrames = 3;
+  int animationFps = 20;
+  sf::Clock animationClock;
+  int presentedFrames = 0;
+  int idleFrames = 0;
+  sf::Time sleptTime;
+  sf::Clock statsClock;
+  float presentRate = 0.f;
+  float idleShare = 0.f;
+  float awakeShare = 0.f;
 
 public:
-  Application(std::string v) : VERSION(v) {
+  Application(std::string v, bool given = false, int s = 0)
+      : VERSION(v), seedGiven(given), fixedSeed(s) {
+    assets = new AssetManager();
+    assets->preload();
+
     sf::ContextSettings settings;
     settings.antialiasingLevel = 8;
     ImGui::CreateContext();
 
     ImGuiIO &io = ImGui::GetIO();
-    io.Fonts->AddFontFromFileTTF("./font.ttf", 15.0f);
+    io.Fonts->AddFontFromFileTTF(assets->path("font.ttf").c_str(), 15.0f);
 
 #ifdef _WIN32
     window = new sf::RenderWindow(sf::VideoMode(1600, 900), "",
@@ -55,62 +136,426 @@ public:
     window->resetGLStates();
 
     initMapGen();
-    painter = new Painter(window, mapgen, VERSION);
+    determinism = new DeterminismCheck(mapgen);
+    hasher = new MapHasher(mapgen);
+    stageCache = new StageCache(assets->path("cache"));
+    painter = new Painter(window, mapgen, assets, VERSION);
+    painter->scheduler = &scheduler;
     generator = std::thread([&]() {});
     regen();
 
     infoWindow = new InfoWindow(window);
+    infoWindow->heights = &painter->heightCache;
     objectsWindow = new ObjectsWindow(window, mapgen);
+    objectsWindow->scheduler = &scheduler;
     simulationWindow = new SimulationWindow(window, mapgen);
+    simulationWindow->sweep->pristine = &pristine;
     weatherWindow = new WeatherWindow(window, mapgen);
   }
 
-  void regen() {
-    if (generator.joinable())
+  // Runs step on the generator thread once the previous step is done. With
+  // hide set the map is taken off screen first, for steps that change it;
+  // such steps show it again when they are done.
+  // A running sweep is stopped after its current run (a new sweep clears
+  // the request when it starts).
+  void launch(std::function<void()> step, bool hide = false) {
+    finishWeather();
+    if (simulationWindow != nullptr) {
+      simulationWindow->sweep->cancel();
+    }
+    if (generator.joinable()) {
       generator.join();
-    generator = std::thread([&]() {
-      lockedRegion = nullptr;
-      rulerRegion = nullptr;
-      lock = false;
+    }
+    if (hide) {
       ready = false;
-      mapgen->update();
-      seed = mapgen->getSeed();
-      relax = mapgen->getRelax();
+    }
+    working = true;
+    generator = std::thread([&, step]() {
+      step();
+      working = false;
+    });
+  }
+
+  // With check set, the current seed is regenerated by the determinism
+  // check instead of a plain update.
+  void regen(bool check = false) {
+    cancelPreview();
+    releaseMap();
+    auto prepared = preparing();
+    int points = nPoints;
+    launch([&, check, prepared, points]() {
+      mapgen->setPointCount(points);
+      // TODO: Lloyd relaxation runs inside MapGenerator::update and lives
+      // in libmapgen. Parallel centroids, skipping cells that barely moved
+      // and per-pass timing need a relax callback or stats from there;
+      // until then only the whole update is timed.
+      sf::Clock clock;
+      if (check) {
+        determinism->run();
+      } else {
+        mapgen->update();
+      }
+      generationTime = clock.getElapsedTime();
+      prepareMap(mapgen, *prepared);
+      installMap(*prepared);
       ready = mapgen->ready;
       painter->invalidate(true);
+    }, true);
+  }
+
+  // Drops everything that points into the current map.
+  void releaseMap() {
+    weatherJob.cancel();
+    weatherJob.wait();
+    scheduler.clear();
+    if (objectsWindow != nullptr) {
+      objectsWindow->invalidate();
+    }
+    if (simulationWindow != nullptr) {
+      simulationWindow->variants.clear();
+    }
+    ruler.clear();
+    lockedRegion = nullptr;
+    rulerRegion = nullptr;
+    currentRegionCache = nullptr;
+    lock = false;
+  }
+
+  // Settings the viewer stages depend on, taken on the main thread.
+  std::shared_ptr<PreparedMap> preparing() {
+    auto prepared = std::make_shared<PreparedMap>();
+    prepared->templateIndex = t;
+    prepared->relief = painter->relief;
+    prepared->rasterResolution = painter->rasterResolution;
+    prepared->size = window->getSize();
+    return prepared;
+  }
+
+  // Viewer state derived from a freshly generated map. Only reads gen and
+  // writes out, so it can run next to the UI.
+  void prepareMap(MapGenerator *gen, PreparedMap &out) {
+    sf::Clock clock;
+    auto &regions = gen->map->regions;
+    MapHasher mapHasher(gen);
+    buildHeights(gen, mapHasher, out.templateIndex, out.heights);
+    mapHasher.hash(&out.heights);
+    out.stages = mapHasher.stages;
+    out.hashTime = mapHasher.hashTime;
+    out.store.build(regions, gen->map->clusters);
+    if (out.relief) {
+      bake(regions[0], out.stages[MapHasher::HEIGHTS], out.size,
+           out.rasterResolution, out.raster);
+    }
+    // Routes read the painter's height cache, which holds these heights
+    // once the map is installed.
+    out.paths->build(regions, gen->map->clusters, &painter->heightCache);
+    out.pristine.capture(gen);
+    out.viewerTime = clock.getElapsedTime();
+  }
+
+  // Swaps the prepared state in. Runs on the main thread, or on the
+  // generator thread while the map is hidden.
+  void installMap(PreparedMap &prepared) {
+    if (largeMapAuto) {
+      painter->largeMap = mapgen->getPointCount() >= largeMapPoints;
+    }
+    if (!painter->largeMap) {
+      painter->resetCamera();
+    }
+    std::swap(painter->heightCache, prepared.heights);
+    std::swap(painter->heightRaster, prepared.raster);
+    std::swap(painter->store, prepared.store);
+    bool hierarchical = paths->hierarchical;
+    std::swap(paths, prepared.paths);
+    paths->hierarchical = hierarchical;
+    std::swap(pristine, prepared.pristine);
+    hasher->stages = prepared.stages;
+    hasher->hashTime = prepared.hashTime;
+    painter->dropWindField();
+    viewerTime = prepared.viewerTime;
+    seed = mapgen->getSeed();
+    relax = mapgen->getRelax();
+    enforceBudget();
+  }
+
+  // Parameter edits are debounced, then a coarse map is generated on a
+  // second MapGenerator and refined level by level up to nPoints. Every
+  // level is generated and prepared on the preview thread and swapped in on
+  // the main thread, so the current map stays on screen and the UI
+  // responsive until the next one is ready.
+  void requestPreview() {
+    if (!livePreview) {
+      return;
+    }
+    previewPending = true;
+    previewChanged.restart();
+  }
+
+  // Does not wait for a level still being generated: updatePreview joins
+  // the worker once it is done and drops its map.
+  void cancelPreview() {
+    previewPending = false;
+    previewLevels.clear();
+    previewCancelled = previewWorker.joinable();
+  }
+
+  void startPreview(int points) {
+    if (previewGen == nullptr) {
+      previewGen = new MapGenerator(window->getSize().x, window->getSize().y);
+    }
+    configure(previewGen, points);
+    previewPrepared = preparing();
+    previewDone = false;
+    auto prepared = previewPrepared;
+    previewWorker = std::thread([&, prepared]() {
+      sf::Clock clock;
+      previewGen->update();
+      previewTime = clock.getElapsedTime();
+      prepareMap(previewGen, *prepared);
+      previewDone = true;
     });
   }
+  // Copies the current settings and economy variables to another generator.
+  void configure(MapGenerator *gen, int points) {
+    gen->setSeed(mapgen->getSeed());
+    gen->setMapTemplate(templates[t]);
+    gen->setOctaveCount(octaves);
+    gen->setFrequency(freq);
+    gen->setPointCount(points);
+    *gen->simulator->vars = *mapgen->simulator->vars;
+  }
 
-  void resetSimulation() {
+  // Called every frame from the main loop. New levels are not started while
+  // the generator thread is busy, so the two never share libmapgen's rand().
+  void updatePreview() {
+    if (previewWorker.joinable()) {
+      if (!previewDone) {
+        return;
+      }
+      if (previewPending || previewCancelled) {
+        // Cancelled, or parameters changed while this level was generated.
+        previewWorker.join();
+        previewPrepared = nullptr;
+        previewLevels.clear();
+        previewCancelled = false;
+      } else if (!working) {
+        previewWorker.join();
+        swapPreview();
+      } else {
+        // The map is swapped once the generator thread is done with it.
+        return;
+      }
+    }
+    if (!ready || working) {
+      return;
+    }
+    if (previewPending &&
+        previewChanged.getElapsedTime().asSeconds() > previewDebounce) {
+      previewPending = false;
+      previewLevels.clear();
+      for (int points = std::min(previewPoints, nPoints); points < nPoints;
+           points *= 4) {
+        previewLevels.push_back(points);
+      }
+      previewLevels.push_back(nPoints);
+      std::reverse(previewLevels.begin(), previewLevels.end());
+    }
+    if (!previewLevels.empty()) {
+      startPreview(previewLevels.back());
+      previewLevels.pop_back();
+    }
+  }
+
+  // The coarse level is sized to the frame budget by its last timing. The
+  // level comes prepared, so swapping it in only exchanges buffers and the
+  // map stays on screen.
+  void swapPreview() {
     if (generator.joinable()) {
       generator.join();
     }
-    generator = std::thread([&]() {
-      ready = false;
-      mapgen->simulator->resetAll();
-      ready = mapgen->ready;
-      painter->invalidate(true);
-    });
+    int points = previewGen->getPointCount();
+    if (points < nPoints && points == std::min(previewPoints, nPoints)) {
+      float ms = previewTime.asMicroseconds() / 1000.f;
+      if (ms > previewBudget) {
+        previewPoints = std::max(250, previewPoints / 2);
+      } else if (ms < previewBudget / 4) {
+        previewPoints = std::min(nPoints, previewPoints * 2);
+      }
+    }
+    releaseMap();
+    std::swap(mapgen, previewGen);
+    painter->setMapGenerator(mapgen);
+    objectsWindow->setMapGenerator(mapgen);
+    simulationWindow->setMapGenerator(mapgen);
+    weatherWindow->setMapGenerator(mapgen);
+    hasher->setMapGenerator(mapgen);
+    determinism->setMapGenerator(mapgen);
+    generationTime = previewTime;
+    installMap(*previewPrepared);
+    previewPrepared = nullptr;
+    ready = mapgen->ready;
+    redraw = settleFrames;
   }
 
-  void simulate() {
+  // The pristine snapshot holds everything a run changes, so a reset is a
+  // copy back on the main thread once nothing else touches the map.
+  void resetSimulation() {
+    finishWeather();
     if (generator.joinable()) {
       generator.join();
     }
-    generator = std::thread([&]() {
-      ready = false;
+    pristine.restore(mapgen);
+    painter->invalidate(true);
+  }
+
+  // TODO: parallel stepping belongs to libmapgen's Simulator. It needs a
+  // per-tick step API (parallel per-city production/consumption, then a
+  // deterministic trade reduction) and a progress callback before the
+  // report can be plotted while it grows; until then the map is hidden and
+  // the plots appear when startSimulation returns.
+  void simulate() {
+    launch([&]() {
       mapgen->startSimulation();
-      painter->invalidate();
       ready = mapgen->ready;
       painter->invalidate(true);
+    }, true);
+  }
+
+  // Called every frame from the main loop. Wind edits are recomputed by one
+  // background job at a time while the map stays on screen; a job is
+  // dropped when the sliders move again before it is done. Jobs only start
+  // while the generator thread is idle, as they read the live regions.
+  void updateWeather() {
+    if (weatherJob.running()) {
+      if (weatherWindow->busy()) {
+        weatherJob.cancel();
+      }
+      if (!weatherJob.finished()) {
+        return;
+      }
+      finishWeather();
+    }
+    if (ready && !working && weatherWindow->due()) {
+      float angle, force;
+      weatherWindow->take(angle, force);
+      weatherJob.start(mapgen, angle, force);
+    }
+  }
+
+  // Waits for the weather job, if any, and swaps its results in.
+  void finishWeather() {
+    if (!weatherJob.running()) {
+      return;
+    }
+    auto field = weatherJob.apply();
+    if (field != nullptr) {
+      painter->setWindField(field);
+      painter->invalidateWeather();
+    }
+  }
+
+  // Runs go one after another on the generator thread, re-simulating the
+  // shown map in place. The map stays on screen: updateSweep keeps the
+  // painter from rebuilding layers, and the panels that read cities,
+  // regions or the report are skipped until the sweep is done.
+  void runSweep() {
+    simulationWindow->sweepRunning = true;
+    launch([&]() {
+      simulationWindow->sweep->run();
+      simulationWindow->sweepRunning = false;
     });
   }
 
+  // Called every frame from the main loop.
+  void updateSweep() {
+    bool running = simulationWindow->sweepRunning;
+    if (painter->frozen && !running) {
+      painter->invalidate(true);
+    }
+    painter->frozen = running;
+  }
+
+  // Heights depend on the noise settings and the region geometry; the
+  // geometry hash stands in for seed, point count and relaxation.
+  void buildHeights(MapGenerator *gen, const MapHasher &mapHasher,
+                    int templateIndex, HeightCache &heights) {
+    auto &regions = gen->map->regions;
+    ContentHash key;
+    key.add(mapHasher.stage(MapHasher::GEOMETRY));
+    key.add(gen->getSeed());
+    key.add(gen->getOctaveCount());
+    key.add(gen->getFrequency());
+    key.add(templateIndex);
+    if (!stageCache->read("heights", key.value, [&](std::istream &in) {
+          return heights.read(in, regions);
+        })) {
+      heights.build(regions);
+      stageCache->write("heights", key.value,
+                        [&](std::ostream &out) { heights.write(out); });
+    }
+  }
+
+  void bake(Region *sampler, std::uint64_t heightsHash, sf::Vector2u size,
+            int resolution, HeightRaster &raster) {
+    ContentHash key;
+    key.add(heightsHash);
+    key.add(size.x);
+    key.add(size.y);
+    key.add(resolution);
+    if (stageCache->read("raster", key.value,
+                         [&](std::istream &in) { return raster.read(in); })) {
+      return;
+    }
+    raster.bake(sampler, float(size.x), float(size.y), resolution);
+    stageCache->write("raster", key.value,
+                      [&](std::ostream &out) { raster.write(out); });
+  }
+
+  // Bakes the height raster (if needed) on the generator thread, then runs
+  // the given step there too.
+  void withRaster(std::function<void()> then) {
+    auto size = window->getSize();
+    int resolution = painter->rasterResolution;
+    launch([&, then, size, resolution]() {
+      if (!painter->heightRaster.ready()) {
+        bake(mapgen->map->regions[0], hasher->stages[MapHasher::HEIGHTS],
+             size, resolution, painter->heightRaster);
+      }
+      then();
+      enforceBudget();
+      ready = mapgen->ready;
+      painter->invalidate(true);
+    }, true);
+  }
+
+  // Times the batch router on every city pair by land and every port pair
+  // by sea. The drawn roads are still built by libmapgen; the paths found
+  // here only fill the memo and the routing counters.
+  void routeCities() {
+    launch([&]() {
+      auto queries = paths->cityPairs(mapgen->map->cities, LAND_ROUTE);
+      auto sea = paths->cityPairs(mapgen->map->cities, SEA_ROUTE);
+      queries.insert(queries.end(), sea.begin(), sea.end());
+      paths->routeAll(queries);
+      mg::info("City routes:", int(queries.size()));
+      mg::info("Hierarchy fallbacks:", paths->hierarchy.fallbacks.load());
+      ready = mapgen->ready;
+    }, true);
+  }
+
+  // Without --seed the first map gets a random seed, logged so the map can
+  // be reproduced.
   void initMapGen() {
-    seed = std::chrono::system_clock::now().time_since_epoch().count();
     mapgen = new MapGenerator(window->getSize().x, window->getSize().y);
     // mapgen->setSeed(38007851);
-	mapgen->setSeed(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+    if (seedGiven) {
+      mapgen->setSeed(fixedSeed);
+    } else {
+      std::random_device device;
+      mapgen->setSeed(int(device() & 0x7fffffff));
+      mg::info("Random seed:", mapgen->getSeed());
+    }
+    seed = mapgen->getSeed();
     octaves = mapgen->getOctaveCount();
     freq = mapgen->getFrequency();
     nPoints = mapgen->getPointCount();
@@ -118,8 +563,8 @@ public:
   }
 
   void processEvent(sf::Event event) {
-    sf::Vector2<float> pos =
-        window->mapPixelToCoords(sf::Mouse::getPosition(*window));
+    sf::Vector2<float> pos = window->mapPixelToCoords(
+        sf::Mouse::getPosition(*window), painter->camera);
     ImGui::SFML::ProcessEvent(event);
 
     switch (event.type) {
@@ -137,6 +582,12 @@ public:
         break;
       case sf::Keyboard::M:
         rulerRegion = rulerRegion == nullptr ? mapgen->getRegion(nullptr, pos) : nullptr;
+        if (rulerRegion != nullptr) {
+          ruler.heights = &painter->heightCache;
+          ruler.setOrigin(rulerRegion, mapgen->map, painter->sffont);
+        } else {
+          ruler.clear();
+        }
         break;
       case sf::Keyboard::P:
         painter->roads = !painter->roads;
@@ -191,16 +642,58 @@ public:
     case sf::Event::Resized:
       mapgen->setSize(window->getSize().x, window->getSize().y);
       // mapgen->update();
-      painter->invalidate();
+      painter->resetCamera();
       break;
     case sf::Event::MouseButtonPressed:
       if (event.mouseButton.button == sf::Mouse::Right && painter->info) {
         lock = !lock;
       }
+      if (event.mouseButton.button == sf::Mouse::Middle &&
+          painter->largeMap) {
+        dragging = true;
+        dragFrom = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+      }
+      break;
+    case sf::Event::MouseButtonReleased:
+      if (event.mouseButton.button == sf::Mouse::Middle) {
+        dragging = false;
+      }
+      break;
+    case sf::Event::MouseMoved:
+      if (dragging) {
+        sf::Vector2i to(event.mouseMove.x, event.mouseMove.y);
+        auto view = painter->camera;
+        view.move(window->mapPixelToCoords(dragFrom, view) -
+                  window->mapPixelToCoords(to, view));
+        painter->setCamera(view);
+        dragFrom = to;
+      }
+      break;
+    case sf::Event::MouseWheelScrolled:
+      if (painter->largeMap && !ImGui::GetIO().WantCaptureMouse) {
+        zoomCamera(event.mouseWheelScroll.delta > 0 ? 0.8f : 1.25f,
+                   sf::Vector2i(event.mouseWheelScroll.x,
+                                event.mouseWheelScroll.y));
+      }
       break;
     }
   }
 
+  // Zooms the large map camera around the given pixel, between the whole
+  // map and a 64th of it.
+  void zoomCamera(float factor, sf::Vector2i pixel) {
+    auto view = painter->camera;
+    auto full = window->getDefaultView().getSize();
+    float scale = view.getSize().x * factor / full.x;
+    if (scale > 1.f || scale < 1.f / 64) {
+      return;
+    }
+    auto before = window->mapPixelToCoords(pixel, view);
+    view.zoom(factor);
+    view.move(before - window->mapPixelToCoords(pixel, view));
+    painter->setCamera(view);
+  }
+
   void drawMainWindow() {
     ImGui::Begin("MapGen");
     // ImGui::BeginTabBar("##MainTabBar");
@@ -214,6 +707,54 @@ public:
 
       ImGui::Text("Window size: w:%d h:%d", window->getSize().x,
                   window->getSize().y);
+      ImGui::Text("Frame p50/p95/p99: %.1f/%.1f/%.1f ms (cpu p95 %.1f, "
+                  "present p95 %.1f)",
+                  scheduler.percentile(0.5f), scheduler.percentile(0.95f),
+                  scheduler.percentile(0.99f), scheduler.cpuPercentile(0.95f),
+                  scheduler.presentPercentile(0.95f));
+      ImGui::SliderFloat("Frame budget (ms)", &scheduler.budget, 2.f, 33.f);
+      if (scheduler.pending()) {
+        ImGui::Text("Deferred tasks: %d", scheduler.deferred());
+      }
+      ImGui::Checkbox("Redraw only on changes", &idleRedraw);
+      if (idleRedraw) {
+        ImGui::SliderInt("Animation fps", &animationFps, 5, 60);
+      }
+      ImGui::Text("Presented %.1f fps, idle %.0f%% of iterations, awake "
+                  "%.0f%% of time",
+                  presentRate, idleShare * 100.f, awakeShare * 100.f);
+      if (assets->frames.find("first map frame") != assets->frames.end()) {
+        ImGui::Text("Startup: assets %dms (%d cached, %d decoded), first "
+                    "frame %dms",
+                    assets->loadTime.asMilliseconds(), assets->cached,
+                    assets->decoded,
+                    assets->frames["first map frame"].asMilliseconds());
+      }
+      if (ImGui::TreeNode("Memory")) {
+        drawMemoryReport();
+        ImGui::TreePop();
+      }
+      if (ImGui::TreeNode("Routing")) {
+        if (ImGui::Button("Time city-pair routing")) {
+          routeCities();
+        }
+        if (ImGui::Checkbox("Hierarchical (clusters)", &paths->hierarchical)) {
+          paths->clearMemo();
+        }
+        ImGui::Text("Queries: %d, cache hits %.0f%%, unreachable %d, %dms",
+                    paths->queries, paths->hitRate() * 100.f, paths->unreachable,
+                    paths->routingTime.asMilliseconds());
+        ImGui::Text("Portals: %d (built in %dms)", paths->hierarchy.portals,
+                    paths->hierarchy.buildTime.asMilliseconds());
+        ImGui::Text("Hierarchical routes: %d, fallbacks %d",
+                    paths->hierarchy.routes.load(),
+                    paths->hierarchy.fallbacks.load());
+        if (ruler.origin != nullptr) {
+          ImGui::Text("Ruler trees built in %dms",
+                      ruler.buildTime.asMilliseconds());
+        }
+        ImGui::TreePop();
+      }
 
       ImGui::Text("\n");
       ImGui::Text("Controls:");
@@ -221,19 +762,22 @@ public:
 
         if (ImGui::InputInt("Seed", &seed)) {
           mapgen->setSeed(seed);
+          requestPreview();
         }
 
-        const char *templates[] = {"basic", "archipelago", "new"};
         if (ImGui::Combo("Map template", &t, templates, 3)) {
           mapgen->setMapTemplate(templates[t]);
+          requestPreview();
         }
 
         if (ImGui::SliderInt("Height octaves", &octaves, 1, 10)) {
           mapgen->setOctaveCount(octaves);
+          requestPreview();
         }
 
         if (ImGui::SliderFloat("Height freq", &freq, 0.001, 2.f)) {
           mapgen->setFrequency(freq);
+          requestPreview();
         }
 
         if (ImGui::InputInt("Points", &nPoints)) {
@@ -241,6 +785,65 @@ public:
             nPoints = 5;
           }
           mapgen->setPointCount(nPoints);
+          requestPreview();
+        }
+        ImGui::Checkbox("Live preview", &livePreview);
+        if (livePreview) {
+          ImGui::SameLine();
+          if ((previewWorker.joinable() && !previewCancelled) ||
+              !previewLevels.empty()) {
+            ImGui::Text("refining, %d levels left",
+                        int(previewLevels.size()) + 1);
+          } else {
+            ImGui::Text("coarse level %d points", previewPoints);
+          }
+        }
+        if (ImGui::Checkbox("Large map mode", &painter->largeMap)) {
+          largeMapAuto = false;
+          painter->resetCamera();
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("auto", &largeMapAuto);
+        if (painter->largeMap) {
+          ImGui::SameLine();
+          if (ImGui::Button("Reset view")) {
+            painter->resetCamera();
+          }
+          ImGui::Text("Tiles resident: %d of %d (wheel zooms, middle "
+                      "button pans)",
+                      painter->landMesh.residentCount(),
+                      painter->landMesh.tileCount());
+        }
+        if (ImGui::Checkbox("Mipmapped icons", &painter->mipmapIcons)) {
+          painter->reloadIcons();
+        }
+        ImGui::Text("Last generation: %dms (%d relax passes), viewer "
+                    "caches %dms",
+                    generationTime.asMilliseconds(), relax,
+                    viewerTime.asMilliseconds());
+
+        bool cacheStages = stageCache->enabled;
+        if (ImGui::Checkbox("Viewer stage cache", &cacheStages)) {
+          stageCache->enabled = cacheStages;
+        }
+        ImGui::SameLine();
+        ImGui::Text("%d hits, %d misses, %.1fMB on disk",
+                    stageCache->hits.load(), stageCache->misses.load(),
+                    stageCache->diskBytes() / 1024.f / 1024.f);
+        if (ImGui::Button("Clear stage cache")) {
+          stageCache->purge();
+        }
+        if (hasher->ready() && ImGui::TreeNode("Map hash")) {
+          ImGui::Text("%016llx (%.2fms)", (unsigned long long)hasher->combined(),
+                      hasher->hashTime.asMicroseconds() / 1000.f);
+          for (int s = 0; s < MapHasher::STAGES; s++) {
+            ImGui::Text("%s: %016llx", MapHasher::names[s],
+                        (unsigned long long)hasher->stages[s]);
+          }
+          if (ImGui::Button("Benchmark hash")) {
+            launch([&]() { hasher->benchmark(&painter->heightCache); });
+          }
+          ImGui::TreePop();
         }
 
         if (ImGui::Button("Random")) {
@@ -251,6 +854,18 @@ public:
         if (ImGui::Button("Update")) {
           regen();
         }
+        if (ImGui::Button("Check determinism")) {
+          regen(true);
+        }
+        if (determinism->done) {
+          ImGui::SameLine();
+          ImGui::Text("%s", determinism->passed ? "passed" : "FAILED");
+          for (auto &r : determinism->results) {
+            ImGui::Text("%s: %016llx %s", r.name.c_str(),
+                        (unsigned long long)r.candidate,
+                        r.reference == r.candidate ? "ok" : "differs");
+          }
+        }
 
         ImGui::TreePop();
       }
@@ -266,6 +881,49 @@ public:
         if (ImGui::Checkbox("Minerals", &painter->minerals)) {
           painter->invalidate(true);
         }
+        ImGui::SameLine(120);
+        if (ImGui::Checkbox("Relief", &painter->relief)) {
+          if (painter->relief && !painter->heightRaster.ready()) {
+            withRaster([]() {});
+          } else {
+            painter->invalidate(true);
+          }
+        }
+        if (ImGui::InputInt("Raster resolution", &painter->rasterResolution,
+                            256, 1024)) {
+          painter->rasterResolution =
+              std::min(std::max(painter->rasterResolution, 256),
+                       HeightRaster::maxSide);
+          painter->heightRaster.clear();
+          if (painter->relief) {
+            withRaster([]() {});
+          }
+        }
+        if (ImGui::Button("Export heightmap")) {
+          withRaster([&]() {
+            char s[100];
+            sprintf(s, "%d-height", seed);
+            painter->heightRaster.save(s);
+            mg::info("Heightmap exported:", std::string(s));
+          });
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Benchmark raster")) {
+          withRaster([&]() {
+            painter->heightRaster.benchmark(mapgen->map->regions[0]);
+          });
+        }
+        auto &raster = painter->heightRaster;
+        if (raster.ready()) {
+          ImGui::Text("Raster %dx%d baked in %dms", raster.width,
+                      raster.height, raster.bakeTime.asMilliseconds());
+        }
+        if (raster.rasterNs > 0.f) {
+          ImGui::Text("Lookup %.0fns vs noise %.0fns, error mean %.4f max "
+                      "%.4f",
+                      raster.rasterNs, raster.noiseNs, raster.meanError,
+                      raster.maxError);
+        }
         ImGui::TreePop();
       }
 
@@ -280,6 +938,11 @@ public:
           painter->invalidate();
         }
         ImGui::Checkbox("Walkers*", &painter->showWalkers);
+        if (ImGui::InputInt("Walkers count (0 = per city)",
+                            &painter->walkersCount, 100, 10000)) {
+          painter->walkersCount = std::max(0, painter->walkersCount);
+          painter->resetWalkers();
+        }
         if (ImGui::Checkbox("Labels", &painter->labels)) {
           painter->invalidate();
         }
@@ -319,12 +982,18 @@ public:
     ImGui::End();
 
     ImGui::Begin("Weather");
+    weatherWindow->computing = weatherJob.running();
     weatherWindow->draw(mapgen->weather.get(), painter);
     ImGui::End();
 
 
+    // A running sweep owns the simulation state, only its progress is shown.
+    bool sweeping = simulationWindow->sweepRunning;
     ImGui::Begin("Simulation");
     // if (ImGui::AddTab("Simulation")) {
+    if (sweeping) {
+      simulationWindow->drawSweep();
+    } else {
       simulationWindow->draw();
 
       if (mapgen->simulator->report != nullptr) {
@@ -336,11 +1005,27 @@ public:
       if (ImGui::Button("Start simulation")) {
         simulate();
       }
+      ImGui::Text("\n");
+      simulationWindow->drawVariants();
+      if (simulationWindow->variantLoaded) {
+        simulationWindow->variantLoaded = false;
+        painter->invalidate(true);
+      }
+      simulationWindow->drawSweep();
+      if (simulationWindow->sweepRequested) {
+        simulationWindow->sweepRequested = false;
+        runSweep();
+      }
+    }
     ImGui::End();
     // }
     ImGui::Begin("Objects");
     // if (ImGui::AddTab("Objects")) {
+    if (sweeping) {
+      ImGui::Text("Paused while the sweep runs");
+    } else {
       drawObjects();
+    }
     // }
     // ImGui::EndTabBar();
     ImGui::End();
@@ -368,8 +1053,8 @@ public:
   Region *currentRegionCache = nullptr;
 
   void drawInfo() {
-    sf::Vector2<float> pos =
-        window->mapPixelToCoords(sf::Mouse::getPosition(*window));
+    sf::Vector2<float> pos = window->mapPixelToCoords(
+        sf::Mouse::getPosition(*window), painter->camera);
 
     Region *currentRegion = mapgen->getRegion(currentRegionCache, pos);
     currentRegionCache = currentRegion;
@@ -391,56 +1076,8 @@ public:
     // painter->layers->getLayer("roads")->damaged = true;
 
     if (rulerRegion != nullptr) {
-      sf::ConvexShape rPolygon;
-      PointList points = rulerRegion->getPoints();
-      rPolygon.setPointCount(int(points.size()));
-      for (int pi = 0; pi < int(points.size()); pi++) {
-        Point p = points[pi];
-        rPolygon.setPoint(pi, sf::Vector2f(static_cast<float>(p->x),
-                                           static_cast<float>(p->y)));
-      }
-      rPolygon.setFillColor(sf::Color::Transparent);
-      rPolygon.setOutlineColor(sf::Color::Black);
-      rPolygon.setOutlineThickness(2);
-
-      sf::CircleShape site(2.f);
-      site.setFillColor(sf::Color::Red);
-      site.setPosition(static_cast<float>(rulerRegion->site->x - 1),
-                       static_cast<float>(rulerRegion->site->y - 1));
-      window->draw(rPolygon);
-      window->draw(site);
-
-      sf::Vertex line[2];
-      line[0].position = sf::Vector2f(static_cast<float>(rulerRegion->site->x),
-                                      static_cast<float>(rulerRegion->site->y));
-      line[0].color = sf::Color::Red;
-      line[1].position =
-          sf::Vector2f(static_cast<float>(currentRegion->site->x),
-                       static_cast<float>(currentRegion->site->y));
-      line[1].color = sf::Color::Black;
-
-      window->draw(line, 2, sf::Lines);
-
-      sf::RectangleShape bg;
-      bg.setFillColor(sf::Color::Black);
-      bg.setOutlineColor(sf::Color(30,30,30));
-      bg.setOutlineThickness(1);
-
-      char mt[40];
-      sprintf(mt, "%f",
-              mg::getDistance(rulerRegion->site, currentRegion->site));
-      sf::Text mark(mt, painter->sffont);
-      mark.setCharacterSize(15);
-      mark.setFillColor(sf::Color::White);
-      // mark.setColor(sf::Color::White);
-      mark.setPosition(line[1].position + sf::Vector2f(15.f, 15.f));
-
-      bg.setSize(sf::Vector2f(mark.getGlobalBounds().width + 8, 18));
-      bg.setPosition(
-                     sf::Vector2f(line[1].position + sf::Vector2f(11.f, 15.f)));
-
-      window->draw(bg);
-      window->draw(mark);
+      ruler.hover(currentRegion);
+      window->draw(ruler);
     }
   }
 
@@ -449,15 +1086,95 @@ public:
     painter->drawObjects(objectsWindow->objectPolygons);
   }
 
+  std::vector<std::pair<std::string, std::size_t>> memoryReport() {
+    auto report = painter->memoryReport();
+    std::size_t snapshots = pristine.bytes();
+    for (auto &pair : simulationWindow->variants) {
+      snapshots += pair.second.bytes();
+    }
+    report.push_back(std::make_pair("routing", paths->bytes()));
+    report.push_back(std::make_pair("simulation snapshots", snapshots));
+    return report;
+  }
+
+  // Keeps the viewer under memoryBudget: the tile meshes get what the
+  // other stages leave, and the relief raster is dropped when even that
+  // does not fit.
+  void enforceBudget() {
+    std::size_t budget = std::size_t(memoryBudget) * 1048576;
+    std::size_t others = 0;
+    for (auto &stage : memoryReport()) {
+      others += stage.second;
+    }
+    others -= painter->meshBytes();
+    if (others > budget && painter->heightRaster.ready()) {
+      mg::warn("Over memory budget, dropping relief raster (MB):",
+               int(painter->heightRaster.bytes() / 1048576));
+      others -= painter->heightRaster.bytes();
+      painter->heightRaster.clear();
+      painter->relief = false;
+      painter->invalidate(true);
+    }
+    painter->setMeshBudget(others < budget ? budget - others : 0);
+  }
+
+  void drawMemoryReport() {
+    std::size_t total = 0;
+    for (auto &stage : memoryReport()) {
+      ImGui::Text("%s: %.1f MB", stage.first.c_str(),
+                  stage.second / 1048576.f);
+      total += stage.second;
+    }
+    if (ImGui::InputInt("Budget (MB)", &memoryBudget, 256, 1024)) {
+      memoryBudget = std::max(memoryBudget, 256);
+      enforceBudget();
+    }
+    ImGui::Text("Viewer total: %.1f MB of %d MB%s", total / 1048576.f,
+                memoryBudget,
+                total > std::size_t(memoryBudget) * 1048576 ? " (over budget)"
+                                                            : "");
+  }
+
+  bool needsRedraw() {
+    return redraw > 0 || painter->isDirty() || animationDue() ||
+           scheduler.pending() || weatherWindow->busy() ||
+           (showUI && simulationWindow->sweepRunning);
+  }
+
+  bool animationDue() {
+    return painter->isAnimating() &&
+           animationClock.getElapsedTime().asSeconds() >= 1.f / animationFps;
+  }
+
+  void updateIdleStats() {
+    float elapsed = statsClock.getElapsedTime().asSeconds();
+    if (elapsed < 1.f) {
+      return;
+    }
+    int iterations = presentedFrames + idleFrames;
+    presentRate = presentedFrames / elapsed;
+    idleShare = iterations > 0 ? float(idleFrames) / iterations : 0.f;
+    awakeShare = 1.f - std::min(1.f, sleptTime.asSeconds() / elapsed);
+    presentedFrames = 0;
+    idleFrames = 0;
+    sleptTime = sf::Time();
+    statsClock.restart();
+  }
+
   void serve() {
     sf::Clock deltaClock;
 
     bool faded = false;
+    bool idle = false;
     while (window->isOpen()) {
       sf::Event event;
       while (window->pollEvent(event)) {
         processEvent(event);
+        redraw = settleFrames;
       }
+      updatePreview();
+      updateSweep();
+      updateWeather();
 
       if (!ready) {
         if (!faded) {
@@ -465,10 +1182,33 @@ public:
           faded = true;
         }
         painter->drawLoading();
+        assets->reportFrame("first frame");
         continue;
       }
+      if (faded) {
+        redraw = settleFrames;
+      }
       faded = false;
 
+      updateIdleStats();
+      if (idleRedraw && !needsRedraw()) {
+        idleFrames++;
+        idle = true;
+        sf::Clock sleep;
+        sf::sleep(sf::milliseconds(10));
+        sleptTime += sleep.getElapsedTime();
+        continue;
+      }
+      // Time spent idle is not animation time for ImGui.
+      if (idle) {
+        deltaClock.restart();
+        idle = false;
+      }
+      redraw = std::max(0, redraw - 1);
+      presentedFrames++;
+      animationClock.restart();
+
+      scheduler.beginFrame();
       ImGui::SFML::Update(*window, deltaClock.restart());
 
       painter->draw();
@@ -476,13 +1216,19 @@ public:
       if (showUI) {
         drawMainWindow();
 
-        if (painter->info) {
+        if (painter->info && !simulationWindow->sweepRunning) {
           drawInfo();
         }
       }
 
+      scheduler.runDeferred();
+
+      window->setView(window->getDefaultView());
       ImGui::SFML::Render(*window);
+      scheduler.endCpu();
       window->display();
+      scheduler.endFrame();
+      assets->reportFrame("first map frame");
 
       // if (getScreenshot) {
       //   char s[100];
@@ -503,6 +1249,10 @@ public:
       // }
     }
 
+    // Shutdown is the one place that waits for a preview level in flight.
+    cancelPreview();
+    if (previewWorker.joinable())
+      previewWorker.join();
     if (generator.joinable())
       generator.join();
     ImGui::SFML::Shutdown();
@@ -42,7 +42,8 @@ void InfoWindow::draw(Region *currentRegion) {
 
     ImGui::Text("Site: x:%f y:%f z:%f", currentRegion->site->x,
                 currentRegion->site->y,
-                currentRegion->getHeight(currentRegion->site));
+                heights != nullptr ? heights->site(currentRegion)
+                                   : currentRegion->getHeight(currentRegion->site));
 
     ImGui::Columns(3, "cells");
     ImGui::Separator();
@@ -60,7 +61,8 @@ void InfoWindow::draw(Region *currentRegion) {
       ImGui::NextColumn();
       ImGui::Text("%f", p->y);
       ImGui::NextColumn();
-      ImGui::Text("%f", currentRegion->getHeight(p));
+      ImGui::Text("%f", heights != nullptr ? heights->vertex(currentRegion, pi)
+                                           : currentRegion->getHeight(p));
       ImGui::NextColumn();
     }
 
@@ -1,9 +1,28 @@
 #include "application.cpp"
+#include "mapgen/Delaunay.hpp"
 
 std::string VERSION = "0.7.1";
 
-int main()
+int main(int argc, char **argv)
 {
-  Application app(VERSION);
+  if (argc > 1 && std::string(argv[1]) == "--bench") {
+    Delaunay::benchmark();
+    return 0;
+  }
+  bool seedGiven = false;
+  int seed = 0;
+  if (argc > 1 && std::string(argv[1]) == "--seed") {
+    std::string value = argc > 2 ? argv[2] : "";
+    try {
+      std::size_t end = 0;
+      seed = std::stoi(value, &end);
+      seedGiven = end == value.size();
+    } catch (const std::exception &) {
+    }
+    if (!seedGiven) {
+      mg::warn("Invalid seed, using a random one:", value);
+    }
+  }
+  Application app(VERSION, seedGiven, seed);
   app.serve();
 }
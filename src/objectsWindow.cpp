@@ -59,45 +59,67 @@ void ObjectsWindow::listObjects(std::vector<T *> objects, std::vector<bool> *mas
   }
 }
 
-void ObjectsWindow::higlightCluster(Cluster *cluster) {
-  for (auto region : cluster->regions) {
-    sf::ConvexShape polygon;
-    PointList points = region->getPoints();
-    polygon.setPointCount(points.size());
-    int n = 0;
-    for (PointList::iterator it2 = points.begin(); it2 < points.end();
-         it2++, n++) {
-      sf::Vector2<double> *p = points[n];
-      polygon.setPoint(n, sf::Vector2f(p->x, p->y));
+// Highlight shapes are built once per object (spread across frames by the
+// scheduler) and reused while the object stays selected.
+void ObjectsWindow::higlightRegions(void *key, std::vector<Region *> regions,
+                                    sf::Color col) {
+  auto cached = highlights.find(key);
+  if (cached != highlights.end()) {
+    for (auto &polygon : cached->second) {
+      objectPolygons.push_back(&polygon);
     }
-    sf::Color col = sf::Color(255, 70, 100);
-    col.a = 150;
-    polygon.setFillColor(col);
-    polygon.setOutlineColor(col);
-    polygon.setOutlineThickness(1);
-    objectPolygons.push_back(polygon);
+    return;
   }
-}
 
-void ObjectsWindow::higlightLocation(Location *location) {
-  auto regions = location->region->neighbors;
-  for (auto region : regions) {
-    sf::ConvexShape polygon;
-    PointList points = region->getPoints();
-    polygon.setPointCount(points.size());
-    int n = 0;
-    for (PointList::iterator it2 = points.begin(); it2 < points.end();
-         it2++, n++) {
-      sf::Vector2<double> *p = points[n];
-      polygon.setPoint(n, sf::Vector2f(p->x, p->y));
+  auto build = [this, key, regions, col]() {
+    auto &polygons = highlights[key];
+    for (auto region : regions) {
+      sf::ConvexShape polygon;
+      PointList points = region->getPoints();
+      polygon.setPointCount(points.size());
+      int n = 0;
+      for (PointList::iterator it2 = points.begin(); it2 < points.end();
+           it2++, n++) {
+        sf::Vector2<double> *p = points[n];
+        polygon.setPoint(n, sf::Vector2f(p->x, p->y));
+      }
+      polygon.setFillColor(col);
+      polygon.setOutlineColor(col);
+      polygon.setOutlineThickness(1);
+      polygons.push_back(polygon);
     }
-    sf::Color col = sf::Color(255, 70, 0);
-    col.a = 100;
-    polygon.setFillColor(col);
-    polygon.setOutlineColor(col);
-    polygon.setOutlineThickness(1);
-    objectPolygons.push_back(polygon);
+  };
+
+  if (scheduler == nullptr) {
+    build();
+    higlightRegions(key, regions, col);
+    return;
   }
+  char t[40];
+  sprintf(t, "highlight:%p", key);
+  scheduler->defer(t, build);
+}
+
+void ObjectsWindow::higlightCluster(Cluster *cluster) {
+  sf::Color col = sf::Color(255, 70, 100);
+  col.a = 150;
+  higlightRegions(cluster, cluster->regions, col);
+}
+
+void ObjectsWindow::higlightLocation(Location *location) {
+  sf::Color col = sf::Color(255, 70, 0);
+  col.a = 100;
+  higlightRegions(location, location->region->neighbors, col);
+}
+
+void ObjectsWindow::invalidate() {
+  objectPolygons.clear();
+  highlights.clear();
+}
+
+void ObjectsWindow::setMapGenerator(MapGenerator *m) {
+  mapgen = m;
+  invalidate();
 }
 
 void ObjectsWindow::draw() {
@@ -165,23 +187,9 @@ void ObjectsWindow::draw() {
   // TODO: fix river edition
   listObjects<River>(mapgen->map->rivers, &rivers_selection_mask, "Rivers",
                      (selectedFunc<River>)[&](River * river) {
-                       for (auto region : river->regions) {
-                         sf::ConvexShape polygon;
-                         PointList points = region->getPoints();
-                         polygon.setPointCount(points.size());
-                         int n = 0;
-                         for (PointList::iterator it2 = points.begin();
-                              it2 < points.end(); it2++, n++) {
-                           sf::Vector2<double> *p = points[n];
-                           polygon.setPoint(n, sf::Vector2f(p->x, p->y));
-                         }
-                         sf::Color col = sf::Color(255, 70, 100);
-                         col.a = 150;
-                         polygon.setFillColor(col);
-                         polygon.setOutlineColor(col);
-                         polygon.setOutlineThickness(1);
-                         objectPolygons.push_back(polygon);
-                       }
+                       sf::Color col = sf::Color(255, 70, 100);
+                       col.a = 150;
+                       higlightRegions(river, river->regions, col);
                      },
                      (openedFunc<River>)[&](River * river) {
                        ImGui::Text("Name: %s", river->name.c_str());
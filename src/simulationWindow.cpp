@@ -1,8 +1,22 @@
+#include <fstream>
+
 #include "mapgen/SimulationWindow.hpp"
+#include "mapgen/utils.hpp"
 #include <imgui.h>
 
 SimulationWindow::SimulationWindow(sf::RenderWindow *w, MapGenerator *m)
-    : window(w), mapgen(m) {}
+    : window(w), mapgen(m) {
+  sweep = new SimulationSweep(mapgen);
+  population.scale = 1.f / 1000.f;
+}
+
+void SimulationWindow::setMapGenerator(MapGenerator *m) {
+  mapgen = m;
+  sweep->setMapGenerator(m);
+  variants.clear();
+  population.clear();
+  wealth.clear();
+}
 
 void SimulationWindow::draw() {
 
@@ -148,32 +162,125 @@ void SimulationWindow::draw() {
   if (mapgen->simulator->report != nullptr) {
     ImGui::Text("Last simulation report");
     auto report = mapgen->simulator->report;
-    auto pop = &report->population;
-    if (pop->size() > 0) {
-      char t[1000];
-      sprintf(t, "Total: %f\nAvg: %f\nMax: %d\nMin: %d", pop->back(),
-              pop->back() / mapgen->map->cities.size(), report->maxPopulation,
+    bool changed = population.sync(report->population);
+    changed = wealth.sync(report->wealth) || changed;
+    int cities = std::max(1, int(mapgen->map->cities.size()));
+    if (changed) {
+      char t[256];
+      sprintf(t, "Total: %f\nAvg: %f\nMax: %d\nMin: %d", population.back(),
+              population.back() / cities, report->maxPopulation,
               report->minPopulation);
-      ImGui::PlotLines(t,
-                       [](void *data, int idx) {
-                         return ((std::vector<float> *)data)->at(idx) / 1000.f;
-                       },
-                       (void *)pop, pop->size(), 0.f, "Total Population (k)",
-                       pop->front() / 1000.f, pop->back() / 1000.f,
-                       ImVec2(0, 100));
+      populationLabel = t;
+      sprintf(t, "Total: %f\nAvg: %f\nMax: %f\nMin: %f", wealth.back(),
+              wealth.back() / cities, report->maxWealth, report->minWealth);
+      wealthLabel = t;
     }
 
-    auto w = &mapgen->simulator->report->wealth;
-    if (pop->size() > 0) {
-      char tw[1000];
-      sprintf(tw, "Total: %f\nAvg: %f\nMax: %f\nMin: %f", w->back(), w->back() / mapgen->map->cities.size(), report->maxWealth, report->minWealth);
-      ImGui::PlotLines(tw,
-                       [](void *data, int idx) {
-                         return ((std::vector<float> *)data)->at(idx);
-                       },
-                       (void *)w, pop->size(), 0.f, "Total Wealth", w->front(),
-                       w->back(), ImVec2(0, 100));
+    if (population.size() > 0) {
+      auto &pop = population.downsample(plotPoints);
+      ImGui::PlotLines(populationLabel.c_str(), pop.data(), pop.size(), 0,
+                       "Total Population (k)", population.min() / 1000.f,
+                       population.max() / 1000.f, ImVec2(0, 100));
+    }
+    if (wealth.size() > 0) {
+      auto &w = wealth.downsample(plotPoints);
+      ImGui::PlotLines(wealthLabel.c_str(), w.data(), w.size(), 0,
+                       "Total Wealth", wealth.min(), wealth.max(),
+                       ImVec2(0, 100));
+    }
+    ImGui::Text("Steps: %zu", population.size());
+    if (ImGui::Button("Export report")) {
+      exportReport("report.csv");
     }
     ImGui::Text("\n");
   }
 }
+
+void SimulationWindow::exportReport(std::string path) {
+  std::ofstream out(path);
+  out << "step,population,wealth\n";
+  for (std::size_t i = 0; i < population.size(); i++) {
+    out << i << "," << population.at(i) << ","
+        << (i < wealth.size() ? wealth.at(i) : 0.f) << "\n";
+  }
+  mg::info("Report exported:", path);
+}
+
+// While a sweep runs only its progress is shown; the parameters are in use.
+void SimulationWindow::drawSweep() {
+  if (!ImGui::TreeNode("Parameter sweep")) {
+    return;
+  }
+  if (sweepRunning) {
+    ImGui::Text("Running: %d/%d", sweep->done.load(), sweep->total.load());
+    ImGui::SameLine();
+    if (ImGui::Button("Stop")) {
+      sweep->cancel();
+    }
+    ImGui::TreePop();
+    return;
+  }
+  ImGui::Checkbox("Random sample", &sweep->random);
+  if (sweep->random) {
+    ImGui::InputInt("Samples", &sweep->samples);
+    ImGui::InputInt("Sample seed", &sweep->seed);
+  }
+
+  int runs = sweep->random ? sweep->samples : 1;
+  for (auto &p : sweep->params) {
+    ImGui::PushID(p.name.c_str());
+    ImGui::Checkbox(p.name.c_str(), &p.enabled);
+    if (p.enabled) {
+      ImGui::DragFloatRange2("range", &p.from, &p.to, 0.001f);
+      if (!sweep->random) {
+        ImGui::InputInt("steps", &p.steps);
+        runs *= std::max(1, p.steps);
+      }
+    }
+    ImGui::PopID();
+  }
+
+  ImGui::Text("Runs go one after another on this map.");
+  ImGui::Text("Runs: %d -> %s, %s", runs, sweep->path.c_str(),
+              sweep->seriesPath.c_str());
+  if (ImGui::Button("Run sweep")) {
+    sweepRequested = true;
+  }
+  if (sweep->done > 0) {
+    ImGui::Text("Last sweep: %d runs, %.1fms/run, %.2f runs/s",
+                sweep->done.load(), sweep->msPerRun, sweep->runsPerSecond);
+  }
+  ImGui::TreePop();
+}
+
+// Variants hold only the simulation state, the geography is shared.
+void SimulationWindow::drawVariants() {
+  if (!ImGui::TreeNode("Variants")) {
+    return;
+  }
+  ImGui::InputText("Name", variantName, sizeof(variantName));
+  if (ImGui::Button("Save variant")) {
+    variants[variantName].capture(mapgen);
+  }
+
+  std::string drop;
+  for (auto &pair : variants) {
+    ImGui::PushID(pair.first.c_str());
+    bool valid = pair.second.matches(mapgen);
+    ImGui::Text("%s (%zu bytes)%s", pair.first.c_str(), pair.second.bytes(),
+                valid ? "" : " [other map]");
+    ImGui::SameLine();
+    if (valid && ImGui::Button("Load")) {
+      variantLoaded = pair.second.restore(mapgen);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Drop")) {
+      drop = pair.first;
+    }
+    ImGui::PopID();
+  }
+  if (drop != "") {
+    variants.erase(drop);
+  }
+  ImGui::TreePop();
+}
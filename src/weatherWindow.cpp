@@ -5,28 +5,60 @@
 
 WeatherWindow::WeatherWindow(sf::RenderWindow *w, MapGenerator* m) : window(w), mapgen(m) {}
 
+// Pending wind changes belong to the old map and are dropped.
+void WeatherWindow::setMapGenerator(MapGenerator *m) {
+  mapgen = m;
+  dirty = false;
+  synced = false;
+}
+
+bool WeatherWindow::busy() { return dirty; }
+
+bool WeatherWindow::due() {
+  return dirty && changed.getElapsedTime().asSeconds() > debounce;
+}
+
+void WeatherWindow::take(float &angle, float &force) {
+  dirty = false;
+  angle = windAngle;
+  force = windForce;
+}
 
 //TODO: apply weather change to mapgen
 void WeatherWindow::draw(WeatherManager* weather, Painter* painter) {
-    if (ImGui::SliderFloat("Wind angle", &weather->windAngle, 0.f, 360.f)) {
-        weather->calcHumidity(mapgen->map->regions);
-        weather->calcTemp(mapgen->map->regions);
-        painter->invalidate(true);
+    if (!synced || !dirty) {
+        windAngle = weather->windAngle;
+        windForce = weather->windForce;
+        synced = true;
+    }
+
+    if (ImGui::SliderFloat("Wind angle", &windAngle, 0.f, 360.f)) {
+        dirty = true;
+        changed.restart();
     }
-    if (ImGui::SliderFloat("Wind force", &weather->windForce, 0.f, 1.f)) {
-        weather->calcHumidity(mapgen->map->regions);
-        weather->calcTemp(mapgen->map->regions);
-        painter->invalidate(true);
+    if (ImGui::SliderFloat("Wind force", &windForce, 0.f, 1.f)) {
+        dirty = true;
+        changed.restart();
+    }
+
+    if (dirty || computing) {
+        ImGui::Text("Recomputing weather...");
     }
 
     if (ImGui::Checkbox("Wind", &painter->wind)) {
         painter->invalidate();
     }
     ImGui::SameLine(120);
-    if (ImGui::Checkbox("Humidity", &painter->hum)) {
+    if (ImGui::Checkbox("Arrows", &painter->windArrows)) {
+        painter->layers->getLayer("wind")->damaged = true;
         painter->invalidate();
     }
     ImGui::SameLine(220);
+    ImGui::Checkbox("Flow", &painter->windParticles);
+    if (ImGui::Checkbox("Humidity", &painter->hum)) {
+        painter->invalidate();
+    }
+    ImGui::SameLine(120);
     if (ImGui::Checkbox("Temp", &painter->temp)) {
         painter->invalidate();
     }